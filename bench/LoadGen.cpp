@@ -0,0 +1,400 @@
+// HTTP 压测工具: 多线程, 每个线程一个 EventLoop, 每个连接一个协程 (复用 webcore 的 Socket / Buffer)
+// 场景: keepalive (长连接逐个请求) / pipeline (长连接一次发 depth 个) / short (每个请求新建连接)
+//       / file (长连接请求大文件, 默认 /large.bin, 需先放到 resources/ 下)
+// 模式: 闭环 (--rate 0, 收到响应后立即发下一个) / 开环 (--rate > 0, 按固定速率发送, 不因服务端变慢而少发)
+// 延迟 (协调遗漏校正): 开环从计划发送时间算起; 闭环按该连接的平均间隔补记慢请求期间本应发出的请求
+// 用法: ./loadgen [--host 127.0.0.1] [--port 8080] [--threads 4] [--connections 64] [--duration 10]
+//                 [--scenario keepalive] [--path /] [--depth 8] [--rate 0] [--timeout 5000]
+//                 [--json result.json | -]
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "EventLoop.h"
+#include "Histogram.h"
+#include "IoAwaitable.h"
+#include "Result.h"
+#include "Socket.h"
+#include "Worker.h"
+
+namespace {
+
+enum class Scenario { KeepAlive, Pipeline, Short, File };
+
+struct Options {
+    std::string host{"127.0.0.1"};
+    uint16_t port{8080};
+    int threads{4};
+    int connections{64};
+    int duration{10};  // 秒
+    Scenario scenario{Scenario::KeepAlive};
+    std::string scenarioName{"keepalive"};
+    std::string path;  // 为空时按场景取默认值
+    int depth{8};      // pipeline 每批请求数
+    double rate{0};    // 开环: 所有连接合计的请求/秒; 0 为闭环
+    int timeoutMs{5000};
+    std::string json;  // JSON 输出文件, "-" 为标准输出
+};
+
+// 每个线程一份, 只由该线程写; 所有 Worker 退出后汇总
+struct ThreadStats {
+    Histogram latency;    // 从实际发出请求到收到完整响应 (ns)
+    Histogram corrected;  // 协调遗漏校正后的延迟 (ns)
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t bytes{0};
+    uint64_t status[6]{};  // 按状态码分类, [0] 为无法识别
+};
+
+using SteadyClock = std::chrono::steady_clock;
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   SteadyClock::now().time_since_epoch())
+            .count();
+}
+
+std::atomic<int> g_active{0};  // 仍在运行的连接协程
+int64_t g_endNs{0};            // 压测结束时间, 之后完成的请求不计入
+
+[[noreturn]] void Usage(const char* prog) {
+    std::fprintf(stderr,
+                 "usage: %s [--host ip] [--port n] [--threads n] [--connections n] "
+                 "[--duration s]\n"
+                 "          [--scenario keepalive|pipeline|short|file] [--path p] [--depth n]\n"
+                 "          [--rate req/s] [--timeout ms] [--json file|-]\n",
+                 prog);
+    std::exit(1);
+}
+
+Options ParseArgs(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view key = argv[i];
+        if (i + 1 >= argc) Usage(argv[0]);
+        const char* value = argv[++i];
+        if (key == "--host") {
+            opt.host = value;
+        } else if (key == "--port") {
+            opt.port = static_cast<uint16_t>(std::atoi(value));
+        } else if (key == "--threads") {
+            opt.threads = std::atoi(value);
+        } else if (key == "--connections") {
+            opt.connections = std::atoi(value);
+        } else if (key == "--duration") {
+            opt.duration = std::atoi(value);
+        } else if (key == "--scenario") {
+            opt.scenarioName = value;
+        } else if (key == "--path") {
+            opt.path = value;
+        } else if (key == "--depth") {
+            opt.depth = std::atoi(value);
+        } else if (key == "--rate") {
+            opt.rate = std::atof(value);
+        } else if (key == "--timeout") {
+            opt.timeoutMs = std::atoi(value);
+        } else if (key == "--json") {
+            opt.json = value;
+        } else {
+            Usage(argv[0]);
+        }
+    }
+    if (opt.scenarioName == "keepalive") {
+        opt.scenario = Scenario::KeepAlive;
+    } else if (opt.scenarioName == "pipeline") {
+        opt.scenario = Scenario::Pipeline;
+    } else if (opt.scenarioName == "short") {
+        opt.scenario = Scenario::Short;
+    } else if (opt.scenarioName == "file") {
+        opt.scenario = Scenario::File;
+    } else {
+        Usage(argv[0]);
+    }
+    if (opt.scenario != Scenario::Pipeline) opt.depth = 1;
+    if (opt.path.empty()) opt.path = opt.scenario == Scenario::File ? "/large.bin" : "/";
+    if (opt.threads <= 0 || opt.connections <= 0 || opt.duration <= 0 || opt.depth <= 0 ||
+        opt.rate < 0) {
+        Usage(argv[0]);
+    }
+    opt.threads = std::min(opt.threads, opt.connections);
+    return opt;
+}
+
+/**
+ * @brief 从 buf 中取出一个完整响应
+ * 返回状态码并把响应字节数加到 *bytes; 响应不完整时返回 0 (不取走数据), 格式错误返回 -1
+ */
+int TakeResponse(Buffer& buf, uint64_t* bytes) {
+    std::string_view data(buf.Peek(), buf.ReadableBytes());
+    size_t headerEnd = data.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) return 0;
+    std::string_view header = data.substr(0, headerEnd);
+    if (header.size() < 12 || header.substr(0, 5) != "HTTP/") return -1;
+    int status = std::atoi(std::string(header.substr(9, 3)).c_str());
+
+    // Content-Length (头部名不区分大小写), 缺省为 0
+    size_t bodyLen = 0;
+    for (size_t pos = header.find("\r\n"); pos != std::string_view::npos;
+         pos = header.find("\r\n", pos + 2)) {
+        std::string_view line = header.substr(pos + 2, header.find("\r\n", pos + 2) - pos - 2);
+        constexpr std::string_view kName = "content-length:";
+        if (line.size() > kName.size() &&
+            strncasecmp(line.data(), kName.data(), kName.size()) == 0) {
+            bodyLen = std::strtoull(std::string(line.substr(kName.size())).c_str(), nullptr, 10);
+            break;
+        }
+    }
+    size_t total = headerEnd + 4 + bodyLen;
+    if (data.size() < total) return 0;
+    buf.Retrieve(total);
+    *bytes += total;
+    return status;
+}
+
+// 非阻塞 connect, 等待可写后检查结果
+Task<bool> Connect(Socket& sock, const sockaddr_in& addr, const Options& opt) {
+    sock.SetNonBlocking();
+    int one = 1;
+    setsockopt(sock.getFd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(sock.getFd(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+        co_return true;
+    }
+    if (errno != EINPROGRESS) co_return false;
+    if (co_await IoAwaitable{sock.getFd(), EPOLLOUT, {Deadline::After(opt.timeoutMs)}} != 0) {
+        co_return false;
+    }
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(sock.getFd(), SOL_SOCKET, SO_ERROR, &err, &len);
+    co_return err == 0;
+}
+
+// 挂起到 atNs (定时器为 ms 精度, 向上取整, 不会提前醒来)
+struct SleepUntil {
+    int64_t atNs;
+
+    bool await_ready() { return t_loop == nullptr || NowNs() >= atNs; }
+
+    void await_suspend(std::coroutine_handle<> hd) {
+        int ms = static_cast<int>((atNs - NowNs() + 999999) / 1000000);
+        t_loop->AddTimer(t_loop->NewTimerId(), ms, [hd]() { hd.resume(); });
+    }
+
+    void await_resume() {}
+};
+
+/**
+ * @brief 闭环的协调遗漏校正 (同 HdrHistogram 的 recordValueWithExpectedInterval):
+ * 一次耗时 v 的请求期间, 按期望间隔本应再发出的请求依次补记 v - expected, v - 2*expected, ...
+ */
+void RecordCorrected(Histogram& histogram, uint64_t v, uint64_t expected) {
+    histogram.Record(v);
+    if (expected == 0) return;
+    for (uint64_t missing = v > expected ? v - expected : 0; missing >= expected;
+         missing -= expected) {
+        histogram.Record(missing);
+    }
+}
+
+// 一个连接: 按场景循环发请求直到压测结束
+Task<void> RunConnection(const Options& opt, const sockaddr_in& addr, ThreadStats& stats,
+                         int index) {
+    const bool isShort = opt.scenario == Scenario::Short;
+    std::string request = fmt::format("GET {} HTTP/1.1\r\nHost: {}:{}\r\nConnection: {}\r\n\r\n",
+                                      opt.path, opt.host, opt.port,
+                                      isShort ? "close" : "keep-alive");
+    std::string batch;
+    for (int i = 0; i < opt.depth; ++i) batch += request;
+
+    // 开环: 每个连接分到 rate / connections, 一批 depth 个请求共用一个计划时间, 各连接错开起点
+    const int64_t intervalNs =
+            opt.rate > 0 ? static_cast<int64_t>(1e9 * opt.connections * opt.depth / opt.rate) : 0;
+    int64_t intended = NowNs() + intervalNs * index / opt.connections;
+    int64_t avgNs = 0;  // 闭环: 本连接的平均延迟, 作为校正的期望间隔
+
+    std::optional<Socket> sock;  // 未连接时为空
+    Buffer buf;
+    while (true) {
+        if (intervalNs > 0) {
+            if (intended >= g_endNs) break;
+            co_await SleepUntil{intended};
+        } else if (NowNs() >= g_endNs) {
+            break;
+        }
+        const int64_t start = NowNs();
+        if (!sock) {
+            sock.emplace();
+            buf.RetrieveAll();
+            if (!co_await Connect(*sock, addr, opt)) {
+                ++stats.errors;
+                sock.reset();
+                intended += intervalNs;
+                continue;
+            }
+        }
+
+        //* 发送一批请求 (内核缓冲区满时等待可写)
+        size_t sent = 0;
+        while (sent < batch.size()) {
+            ssize_t n = co_await sock->Write(batch.data() + sent, batch.size() - sent,
+                                            {Deadline::After(opt.timeoutMs)});
+            if (n <= 0) break;
+            sent += static_cast<size_t>(n);
+        }
+
+        //* 读取同样数量的响应
+        int received = 0;
+        bool ok = sent == batch.size();
+        while (ok && received < opt.depth) {
+            int status = TakeResponse(buf, &stats.bytes);
+            if (status > 0) {
+                const int64_t now = NowNs();
+                if (now <= g_endNs) {
+                    const int64_t latency = now - start;
+                    if (intervalNs > 0) {
+                        stats.corrected.Record(static_cast<uint64_t>(now - intended));
+                    } else {
+                        RecordCorrected(stats.corrected, latency, avgNs);
+                        avgNs = avgNs == 0 ? latency : avgNs + (latency - avgNs) / 8;
+                    }
+                    stats.latency.Record(static_cast<uint64_t>(latency));
+                    ++stats.requests;
+                    ++stats.status[status >= 200 && status < 600 ? status / 100 : 0];
+                }
+                ++received;
+                continue;
+            }
+            if (status < 0) {
+                ok = false;
+                break;
+            }
+            ssize_t n = co_await sock->Read(buf, {Deadline::After(opt.timeoutMs)});
+            if (n <= 0) ok = false;
+        }
+        if (!ok && NowNs() < g_endNs) ++stats.errors;
+        if (!ok || isShort) {
+            sock.reset();  // 关闭连接, 下一轮重连
+        }
+        intended += intervalNs;
+    }
+    g_active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// 分位数 (ms) 的 JSON 对象
+std::string LatencyJson(const Histogram::Snapshot& s) {
+    return fmt::format(
+            "{{\"count\": {}, \"mean\": {:.3f}, \"p50\": {:.3f}, \"p90\": {:.3f}, \"p99\": {:.3f}, "
+            "\"p999\": {:.3f}, \"max\": {:.3f}}}",
+            s.count, s.count > 0 ? s.sum / 1e6 / s.count : 0.0, s.Percentile(0.5) / 1e6,
+            s.Percentile(0.9) / 1e6, s.Percentile(0.99) / 1e6, s.Percentile(0.999) / 1e6,
+            s.max / 1e6);
+}
+
+void PrintLatency(const char* name, const Histogram::Snapshot& s) {
+    std::printf("  %-22s p50 %9.3f  p90 %9.3f  p99 %9.3f  p99.9 %9.3f  max %9.3f ms\n", name,
+                s.Percentile(0.5) / 1e6, s.Percentile(0.9) / 1e6, s.Percentile(0.99) / 1e6,
+                s.Percentile(0.999) / 1e6, s.max / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options opt = ParseArgs(argc, argv);
+    Log::getInstance()->Init(3, "./log", ".log", 1024);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    if (inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr) != 1) {
+        std::fprintf(stderr, "invalid host: %s\n", opt.host.c_str());
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<ThreadStats>> stats;
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < opt.threads; ++i) {
+        stats.push_back(std::make_unique<ThreadStats>());
+        workers.push_back(std::make_unique<Worker>(i));
+    }
+
+    std::printf("loadgen: %s http://%s:%u%s, %d threads, %d connections, %ds, %s\n",
+                opt.scenarioName.c_str(), opt.host.c_str(), opt.port, opt.path.c_str(), opt.threads,
+                opt.connections, opt.duration,
+                opt.rate > 0 ? fmt::format("open loop {:.0f} req/s", opt.rate).c_str()
+                             : "closed loop");
+
+    const int64_t startNs = NowNs();
+    g_endNs = startNs + static_cast<int64_t>(opt.duration) * 1000000000;
+    g_active.store(opt.connections, std::memory_order_relaxed);
+    for (int c = 0; c < opt.connections; ++c) {
+        const int t = c % opt.threads;
+        ThreadStats* threadStats = stats[t].get();
+        workers[t]->getLoop()->RunInLoop([&opt, &addr, threadStats, c]() {
+            RunConnection(opt, addr, *threadStats, c).Detach();
+        });
+    }
+
+    //* 等到结束时间, 再给未完成的请求一个超时的时间退出; Worker 析构时取消仍挂起的协程
+    std::this_thread::sleep_for(std::chrono::seconds(opt.duration));
+    const int64_t graceEnd = NowNs() + static_cast<int64_t>(opt.timeoutMs) * 1000000;
+    while (g_active.load(std::memory_order_relaxed) > 0 && NowNs() < graceEnd) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    workers.clear();
+
+    ThreadStats total;
+    Histogram::Snapshot latency, corrected;
+    for (auto& s : stats) {
+        s->latency.AddTo(latency);
+        s->corrected.AddTo(corrected);
+        total.requests += s->requests;
+        total.errors += s->errors;
+        total.bytes += s->bytes;
+        for (int i = 0; i < 6; ++i) total.status[i] += s->status[i];
+    }
+    const double seconds = opt.duration;
+    const double rps = total.requests / seconds;
+    const double mbps = total.bytes / seconds / (1 << 20);
+
+    std::printf("  requests %lu (%.1f req/s), %.2f MB/s, errors %lu, 2xx %lu 3xx %lu 4xx %lu 5xx %lu\n",
+                total.requests, rps, mbps, total.errors, total.status[2], total.status[3],
+                total.status[4], total.status[5]);
+    PrintLatency("latency", latency);
+    PrintLatency("latency (CO-corrected)", corrected);
+
+    if (!opt.json.empty()) {
+        std::string json = fmt::format(
+                "{{\n  \"scenario\": \"{}\", \"mode\": \"{}\", \"path\": \"{}\",\n"
+                "  \"threads\": {}, \"connections\": {}, \"depth\": {}, \"duration_s\": {}, "
+                "\"target_rate\": {},\n"
+                "  \"requests\": {}, \"errors\": {}, \"throughput_rps\": {:.1f}, "
+                "\"throughput_mbps\": {:.3f},\n"
+                "  \"status\": {{\"2xx\": {}, \"3xx\": {}, \"4xx\": {}, \"5xx\": {}, \"other\": {}}},\n"
+                "  \"latency_ms\": {},\n  \"latency_corrected_ms\": {}\n}}\n",
+                opt.scenarioName, opt.rate > 0 ? "open" : "closed", opt.path, opt.threads,
+                opt.connections, opt.depth, opt.duration, opt.rate, total.requests, total.errors,
+                rps, mbps, total.status[2], total.status[3], total.status[4], total.status[5],
+                total.status[0] + total.status[1], LatencyJson(latency), LatencyJson(corrected));
+        if (opt.json == "-") {
+            std::cout << json << std::flush;
+        } else {
+            std::ofstream(opt.json) << json;
+        }
+    }
+    Log::getInstance()->Flush();
+    return total.requests > 0 ? 0 : 1;
+}
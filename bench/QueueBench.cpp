@@ -0,0 +1,138 @@
+// 队列吞吐对比: BlockQueue vs MpmcQueue (单个 / 批量)
+// 用法: ./bench_queue [每轮总元素数, 默认 2000000] [消费者数, 默认 4]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "BlockQueue.h"
+#include "MpmcQueue.h"
+
+namespace {
+
+constexpr size_t QUEUE_CAPACITY = 4096;
+constexpr size_t BATCH = 32;
+constexpr long STOP = -1;  // 每个消费者收到一个结束标记
+
+// 运行一轮: producers 个生产者共写入 total 个元素, consumers 个消费者取完, 返回 Mops/s
+template <typename Produce, typename Consume>
+double Run(int producers, int consumers, size_t total, Produce&& produce, Consume&& consume) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back(consume);
+    }
+    std::vector<std::thread> producerThreads;
+    for (int p = 0; p < producers; ++p) {
+        size_t count = total / producers + (static_cast<size_t>(p) < total % producers ? 1 : 0);
+        producerThreads.emplace_back(produce, count);
+    }
+    for (auto& t : producerThreads) t.join();
+    // 生产者结束后再发结束标记, 保证消费者取完所有元素
+    for (int c = 0; c < consumers; ++c) produce(0, true);
+    for (auto& t : threads) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total / sec / 1e6;
+}
+
+double BenchBlockQueue(int producers, int consumers, size_t total) {
+    BlockQueue<long> queue(QUEUE_CAPACITY);
+    return Run(
+            producers, consumers, total,
+            [&](size_t count, bool stop = false) {
+                if (stop) {
+                    queue.push_back(STOP);
+                    return;
+                }
+                for (size_t i = 0; i < count; ++i) queue.push_back(static_cast<long>(i));
+            },
+            [&]() {
+                long item;
+                while (queue.pop(item) && item != STOP) {
+                }
+            });
+}
+
+double BenchMpmc(int producers, int consumers, size_t total) {
+    MpmcQueue<long> queue(QUEUE_CAPACITY);
+    return Run(
+            producers, consumers, total,
+            [&](size_t count, bool stop = false) {
+                if (stop) {
+                    queue.push_back(STOP);
+                    return;
+                }
+                for (size_t i = 0; i < count; ++i) queue.push_back(static_cast<long>(i));
+            },
+            [&]() {
+                long item;
+                while (queue.pop(item) && item != STOP) {
+                }
+            });
+}
+
+double BenchMpmcBatch(int producers, int consumers, size_t total) {
+    MpmcQueue<long> queue(QUEUE_CAPACITY);
+    return Run(
+            producers, consumers, total,
+            [&](size_t count, bool stop = false) {
+                if (stop) {
+                    queue.push_back(STOP);
+                    return;
+                }
+                long items[BATCH];
+                size_t sent = 0;
+                while (sent < count) {
+                    size_t n = std::min(BATCH, count - sent);
+                    for (size_t i = 0; i < n; ++i) items[i] = static_cast<long>(sent + i);
+                    size_t done = 0;
+                    while (done < n) {
+                        size_t pushed = queue.push_n(items + done, n - done);
+                        if (pushed == 0) {
+                            queue.push_back(std::move(items[done]));  // 满了: 阻塞等待空位
+                            pushed = 1;
+                        }
+                        done += pushed;
+                    }
+                    sent += n;
+                }
+            },
+            [&]() {
+                long items[BATCH];
+                while (true) {
+                    size_t n = queue.pop_n(items, BATCH);
+                    if (n == 0) {
+                        if (!queue.pop(items[0])) return;  // 空了: 阻塞等待
+                        n = 1;
+                    }
+                    for (size_t i = 0; i < n; ++i) {
+                        //! 结束标记之后不会再有本消费者需要的元素, 但批量可能多取了别的标记
+                        if (items[i] == STOP) {
+                            for (size_t j = i + 1; j < n; ++j) {
+                                if (items[j] == STOP) queue.push_back(STOP);  // 还给其他消费者
+                            }
+                            return;
+                        }
+                    }
+                }
+            });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t total = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    int consumers = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    std::printf("total=%zu consumers=%d capacity=%zu batch=%zu (Mops/s)\n", total, consumers,
+                QUEUE_CAPACITY, BATCH);
+    std::printf("%9s %12s %12s %12s\n", "producers", "BlockQueue", "MpmcQueue", "Mpmc push_n");
+    for (int producers = 1; producers <= 64; producers *= 2) {
+        double block = BenchBlockQueue(producers, consumers, total);
+        double mpmc = BenchMpmc(producers, consumers, total);
+        double batch = BenchMpmcBatch(producers, consumers, total);
+        std::printf("%9d %12.2f %12.2f %12.2f\n", producers, block, mpmc, batch);
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+
+/**
+ * @brief CPU 亲和性配置
+ */
+struct AffinityOptions {
+    bool pinWorkers{true};    // 每个 Worker 绑定到一个核, 避免 Loop 在核之间迁移
+    int reservedCores{0};     // 给 Acceptor (主线程) 和日志线程预留的核数, 0 表示不预留
+    bool numaLocal{true};     // Worker 的内存优先从其所在 NUMA 节点分配
+    bool incomingCpu{true};   // 按 SO_INCOMING_CPU 把连接分派给处理其网卡 RX 队列的核上的 Worker
+};
+
+/**
+ * @brief CPU 绑核 / NUMA 本地分配 / 网卡 RX 队列对齐
+ * @details 不依赖 libnuma: 节点信息读 /sys, 内存策略直接调用 set_mempolicy.
+ * 绑核要在线程创建 Loop 之前完成, 之后 Loop 的缓冲区池、定时器堆等按首次访问落在本地节点
+ */
+class Affinity {
+public:
+    struct Plan {
+        std::vector<int> reservedCpus;  // Acceptor 和日志线程使用的核 (空表示不预留)
+        std::vector<int> workerPool;    // 未预留的核
+        std::vector<int> workerCpus;    // 第 i 个 Worker 绑定的核, 不绑核时为空
+        int workerNum{0};               // 建议的 Worker 数: 未预留的核数
+
+        // 第 i 个 Worker 线程允许运行的核: 绑核时为单核; 不绑核但有预留时为全部未预留的核
+        // (不能继承主线程的预留核); 都没有时为空, 不设置亲和性
+        std::vector<int> CpusOf(int worker) const {
+            if (!workerCpus.empty()) return {workerCpus[worker % workerCpus.size()]};
+            if (!reservedCpus.empty()) return workerPool;
+            return {};
+        }
+    };
+
+    // 本进程允许运行的 CPU (sched_getaffinity), 升序
+    static std::vector<int> AvailableCpus();
+
+    /**
+     * @brief 按配置划分 CPU: 前 reservedCores 个核预留, 其余每核一个 Worker
+     * 可用核不多于预留数时放弃预留 (至少要留一个核给 Worker)
+     */
+    static Plan MakePlan(const AffinityOptions& options);
+
+    // 把当前线程绑定到 cpus (为空时不做任何事)
+    static bool PinCurrentThread(const std::vector<int>& cpus);
+
+    // cpu 所在的 NUMA 节点, 未知时返回 -1
+    static int NodeOfCpu(int cpu);
+
+    // 系统 NUMA 节点数 (读不到时视为 1)
+    static int NodeCount();
+
+    // 当前线程之后的内存分配优先使用 node 上的内存 (MPOL_PREFERRED)
+    static bool PreferNode(int node);
+
+    // 处理该连接最近一个入站包的 CPU (SO_INCOMING_CPU), 不支持时返回 -1
+    static int GetIncomingCpu(int fd);
+};
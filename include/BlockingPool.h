@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "EventLoop.h"
+#include "MpmcQueue.h"
+#include "RemoteCall.h"
+
+/**
+ * @brief 有界的阻塞任务线程池: 运行会阻塞或长时间占用 CPU 的调用 (同步库、密码哈希、文件摘要)
+ * @details 任务放进有界 MPMC 队列, 固定数量的辅助线程取出执行. 与 Compute (工作窃取) 不同,
+ * 这些任务不在任何 EventLoop 线程上运行, 阻塞再久也不会拖慢其他连接.
+ * 排队数超过上限时直接拒绝 (OffloadRejected), 不让突发请求在队列里无限堆积
+ */
+class BlockingPool {
+public:
+    // 队列中的任务: run 在辅助线程上调用
+    struct Job {
+        void (*run)(Job* job){nullptr};
+        int64_t enqueueNs{0};
+    };
+
+    // 累计统计 (近似值, 各字段独立读取)
+    struct Stats {
+        uint64_t submitted;  // 成功入队
+        uint64_t rejected;   // 队列满被拒绝
+        uint64_t completed;  // 执行完成
+        int64_t queued;      // 当前排队数
+        int64_t running;     // 当前执行数
+        uint64_t waitNs;     // 累计排队时间
+        uint64_t runNs;      // 累计执行时间
+        uint64_t maxWaitNs;  // 最长排队时间
+    };
+
+    static BlockingPool* getInstance() {
+        static BlockingPool pool;
+        return &pool;
+    }
+
+    /**
+     * @brief 启动辅助线程
+     * @param threads 线程数
+     * @param maxQueue 最多排队的任务数, 超过时 Submit 失败
+     * @param onThreadStart / onThreadExit 每个辅助线程启动/退出时调用 (如 mysql_thread_init/end)
+     */
+    void Init(int threads, size_t maxQueue, std::function<void()> onThreadStart = {},
+              std::function<void()> onThreadExit = {});
+
+    // 停止接收任务, 执行完已排队的任务后回收线程
+    void Shutdown();
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // 提交任务, 未启动或队列已满时返回 false
+    bool Submit(Job* job);
+
+    Stats getStats() const;
+
+private:
+    BlockingPool() = default;
+    ~BlockingPool() { Shutdown(); }
+
+    void WorkerThread();
+
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    std::unique_ptr<MpmcQueue<Job*>> queue_;
+    std::vector<std::thread> threads_;
+    std::function<void()> onThreadStart_;
+    std::function<void()> onThreadExit_;
+    size_t maxQueue_{0};
+    std::atomic<bool> running_{false};
+
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<int64_t> queued_{0};
+    std::atomic<int64_t> active_{0};
+    std::atomic<uint64_t> waitNs_{0};
+    std::atomic<uint64_t> runNs_{0};
+    std::atomic<uint64_t> maxWaitNs_{0};
+};
+
+// BlockingPool 队列已满
+class OffloadRejected : public std::runtime_error {
+public:
+    OffloadRejected() : std::runtime_error("BlockingPool queue is full") {}
+};
+
+/**
+ * @brief 在 BlockingPool 的辅助线程上执行 fn, 完成后通过任务队列回到原 Loop 恢复协程
+ * 用法: bool ok = co_await Offload([&] { return stmt->Execute(); });
+ * fn 的异常在 co_await 处重新抛出; 队列已满时抛出 OffloadRejected.
+ * 不在 Loop 线程或线程池未启动时直接在当前线程执行
+ * @note fn 不能访问只属于原 Loop 的资源 (t_loop、BufferPool、Socket IO); 捕获的引用在 co_await 期间有效
+ */
+template <typename F>
+auto Offload(F fn) {
+    struct OffloadAwaitable : BlockingPool::Job, RemoteCall<F> {
+        bool rejected{false};
+
+        explicit OffloadAwaitable(F&& f) : RemoteCall<F>(std::move(f)) { run = &Run; }
+
+        static void Run(BlockingPool::Job* job) {
+            auto* self = static_cast<OffloadAwaitable*>(job);
+            self->Invoke();
+            //! 辅助线程不是任何 Loop: 总是投递回原 Loop, 之后不能再访问 self
+            self->ResumeHome(nullptr);
+        }
+
+        bool await_ready() { return t_loop == nullptr || !BlockingPool::getInstance()->IsRunning(); }
+
+        bool await_suspend(std::coroutine_handle<> hd) {
+            this->Park(hd);
+            if (!BlockingPool::getInstance()->Submit(this)) {
+                rejected = true;
+                return false;  // 不挂起, 在 await_resume 里报告
+            }
+            return true;
+        }
+
+        auto await_resume() {
+            if (rejected) throw OffloadRejected();
+            return this->Result();  // 没有挂起时就地执行
+        }
+    };
+    return OffloadAwaitable{std::move(fn)};
+}
@@ -85,6 +85,12 @@ public:
         }
     }
 
+    // 占用的内存大小
+    size_t Capacity() const { return buffer_.capacity(); }
+
+    // 收缩: 释放多余内存, 只保留可读数据和 reserve 字节的可写空间
+    void Shrink(size_t reserve = kInitialSize);
+
     // 从 fd 读取数据 (处理 ET 模式的关键)
     ssize_t ReadFd(int fd, int* saveErrno);
 
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+
+/**
+ * @brief 读缓冲区池: 每个 EventLoop 一个, 只在本 Loop 线程使用, 不加锁
+ * @details 连接只在有数据要处理时才借出 Buffer, 处理完 (缓冲区读空) 立即归还,
+ * 空闲的长连接不占用任何读缓冲区. 归还时执行高水位收缩:
+ * 1. 单个 Buffer 容量超过 kHighWater (大请求撑大的) 收缩回初始大小
+ * 2. 每隔 kTrimIntervalMs 把空闲链表裁剪到上一周期的借出峰值, 多余的释放
+ * 统计值为原子变量, 允许其他线程读取 (用于 RSS/连接 指标)
+ */
+class BufferPool {
+public:
+    static constexpr size_t kHighWater{64 * 1024UL};  // 归还时超过该容量则收缩
+    static constexpr size_t kMaxIdle{256};            // 空闲链表上限
+    static constexpr int kTrimIntervalMs{10000};      // 空闲链表裁剪周期
+
+    /**
+     * @brief 借出的缓冲区 (RAII): 析构或 Release() 时归还到池, 只能移动
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease() { Release(); }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other) noexcept : pool_(other.pool_), buf_(std::move(other.buf_)) {
+            other.pool_ = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                Release();
+                pool_ = other.pool_;
+                buf_ = std::move(other.buf_);
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+
+        // 归还缓冲区 (未读数据会被丢弃)
+        void Release() {
+            if (pool_ != nullptr && buf_ != nullptr) {
+                pool_->Recycle(std::move(buf_));
+            }
+            pool_ = nullptr;
+        }
+
+        explicit operator bool() const { return buf_ != nullptr; }
+        Buffer& operator*() const { return *buf_; }
+        Buffer* operator->() const { return buf_.get(); }
+
+    private:
+        friend class BufferPool;
+        Lease(BufferPool* pool, std::unique_ptr<Buffer> buf) : pool_(pool), buf_(std::move(buf)) {}
+
+        BufferPool* pool_{nullptr};
+        std::unique_ptr<Buffer> buf_;
+    };
+
+    BufferPool() = default;
+
+    // 禁止拷贝
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 借出一个空缓冲区, 优先复用空闲链表
+    Lease Acquire();
+
+    //* 统计 (近似值, 可跨线程读取)
+    size_t getInUse() const { return inUse_.load(std::memory_order_relaxed); }
+    size_t getIdle() const { return idle_.load(std::memory_order_relaxed); }
+    size_t getIdleBytes() const { return idleBytes_.load(std::memory_order_relaxed); }
+    uint64_t getShrinkCount() const { return shrinks_.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Recycle(std::unique_ptr<Buffer> buf);
+
+    // 空闲链表裁剪到 keep 个
+    void Trim(size_t keep);
+
+    std::vector<std::unique_ptr<Buffer>> free_;
+    size_t peakInUse_{0};  // 本周期借出峰值
+    Clock::time_point lastTrim_{Clock::now()};
+
+    std::atomic<size_t> inUse_{0};
+    std::atomic<size_t> idle_{0};
+    std::atomic<size_t> idleBytes_{0};
+    std::atomic<uint64_t> shrinks_{0};
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 截止时间 (单调时钟), 默认构造表示永不超时
+ */
+class Deadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Deadline() = default;
+    explicit Deadline(Clock::time_point at) : at_(at), never_(false) {}
+
+    // 从现在起 ms 毫秒后到期
+    static Deadline After(int ms) { return Deadline(Clock::now() + std::chrono::milliseconds(ms)); }
+
+    bool IsNever() const { return never_; }
+    bool Expired() const { return !never_ && Clock::now() >= at_; }
+
+    // 剩余毫秒数 (向上取整, 已到期为 0), 永不超时返回 -1
+    int RemainingMs() const {
+        if (never_) return -1;
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(at_ - Clock::now()).count();
+        return left > 0 ? static_cast<int>(left) : 0;
+    }
+
+private:
+    Clock::time_point at_{};
+    bool never_{true};
+};
+
+namespace detail {
+struct CancelState {
+    bool cancelled{false};
+    uint64_t nextId{0};
+    std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+};
+}  // namespace detail
+
+/**
+ * @brief 取消回调的注册凭证 (RAII): 析构时注销回调, 只能移动
+ */
+class CancellationRegistration {
+public:
+    CancellationRegistration() = default;
+    CancellationRegistration(std::weak_ptr<detail::CancelState> state, uint64_t id)
+        : state_(std::move(state)), id_(id) {}
+    ~CancellationRegistration() { Reset(); }
+
+    CancellationRegistration(const CancellationRegistration&) = delete;
+    CancellationRegistration& operator=(const CancellationRegistration&) = delete;
+    CancellationRegistration(CancellationRegistration&& other) noexcept
+        : state_(std::move(other.state_)), id_(other.id_) {}
+    CancellationRegistration& operator=(CancellationRegistration&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            state_ = std::move(other.state_);
+            id_ = other.id_;
+        }
+        return *this;
+    }
+
+    // 注销回调 (回调已执行或已注销时无操作)
+    void Reset() {
+        if (auto state = state_.lock()) {
+            std::erase_if(state->callbacks, [this](const auto& cb) { return cb.first == id_; });
+        }
+        state_.reset();
+    }
+
+private:
+    std::weak_ptr<detail::CancelState> state_;
+    uint64_t id_{0};
+};
+
+/**
+ * @brief 取消令牌: 由 CancellationSource 发放, 可拷贝; 默认构造的令牌永远不会被取消
+ */
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    bool CanBeCancelled() const { return state_ != nullptr; }
+    bool IsCancelled() const { return state_ != nullptr && state_->cancelled; }
+
+    /**
+     * @brief 注册取消回调, 在 Cancel() 时同步执行; 已取消时立即执行并返回空凭证
+     */
+    [[nodiscard]] CancellationRegistration OnCancel(std::function<void()> callback) const {
+        if (state_ == nullptr) return {};
+        if (state_->cancelled) {
+            callback();
+            return {};
+        }
+        uint64_t id = ++state_->nextId;
+        state_->callbacks.emplace_back(id, std::move(callback));
+        return CancellationRegistration(state_, id);
+    }
+
+private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<detail::CancelState> state)
+        : state_(std::move(state)) {}
+
+    std::shared_ptr<detail::CancelState> state_;
+};
+
+/**
+ * @brief 取消源: Cancel() 通知所有令牌, 执行已注册的回调
+ * @note 与 EventLoop 一样按线程使用: 令牌只能在所属 Loop 线程注册和取消,
+ * 跨线程取消需通过 RunInLoop 投递到该 Loop
+ */
+class CancellationSource {
+public:
+    CancellationSource() : state_(std::make_shared<detail::CancelState>()) {}
+
+    CancellationToken Token() const { return CancellationToken(state_); }
+
+    bool IsCancelled() const { return state_->cancelled; }
+
+    void Cancel() {
+        if (state_->cancelled) return;
+        state_->cancelled = true;
+        // 逐个取出再执行: 回调会恢复协程, 协程可能注销尚未执行的回调或销毁本对象
+        auto state = state_;
+        while (!state->callbacks.empty()) {
+            auto callback = std::move(state->callbacks.back().second);
+            state->callbacks.pop_back();
+            callback();
+        }
+    }
+
+private:
+    std::shared_ptr<detail::CancelState> state_;
+};
+
+/**
+ * @brief IO 等待选项: 截止时间 + 取消令牌
+ * 超时以 ETIMEDOUT、取消以 ECANCELED 结束等待
+ */
+struct IoOptions {
+    Deadline deadline;
+    CancellationToken token;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <sys/types.h>
+#include <sys/uio.h>  // iovec
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 分段缓冲区: 由固定大小的内存块 (slab) 串成的链
+ * @details 写入只在链尾追加 slab, 不会 realloc 也不搬移已有数据;
+ * 取走数据时整块释放回线程内的 slab 池; 输出时把各段直接组成 iovec 交给 writev,
+ * 从拼装报文到进入 socket 之间没有额外拷贝.
+ * 只用于发送: 读请求仍用连续的 Buffer (从 BufferPool 借), HTTP 解析器需要连续内存
+ *
+ *   +--------+     +--------+     +--------+
+ *   | slab 0 | --> | slab 1 | --> | slab 2 |
+ *   +--------+     +--------+     +--------+
+ *    ^begin                             ^end
+ */
+class ChainBuffer {
+public:
+    static constexpr size_t kSlabSize{4096UL};       // 每个 slab 4KB (一页)
+    static constexpr int kMaxWriteIov{64};           // 一次 writev 最多 64 段
+    static constexpr size_t kMaxPooledSlabs{256};    // 每个线程缓存的空闲 slab 上限 (1MB)
+
+    ChainBuffer() = default;
+    ~ChainBuffer() { RetrieveAll(); }
+
+    // 禁止拷贝, 允许移动
+    ChainBuffer(const ChainBuffer&) = delete;
+    ChainBuffer& operator=(const ChainBuffer&) = delete;
+    ChainBuffer(ChainBuffer&& other) noexcept;
+    ChainBuffer& operator=(ChainBuffer&& other) noexcept;
+
+    // 可读字节数
+    size_t ReadableBytes() const { return readable_; }
+
+    // 占用的 slab 数
+    size_t SlabCount() const { return segs_.size(); }
+
+    // 写入数据 (追加到链尾)
+    void Append(const char* data, size_t len);
+    void Append(std::string_view str) { Append(str.data(), str.size()); }
+
+    // 取出 len 长度的数据, 读完的 slab 归还到池
+    void Retrieve(size_t len);
+    void RetrieveAll();
+
+    // 取出所有数据转为 string (会拷贝, 仅用于调试/小数据)
+    std::string RetrieveAllToStr();
+
+    // 把可读数据按段填入 vec (最多 maxCnt 段), 返回段数
+    int GetIoVec(struct iovec* vec, int maxCnt) const;
+
+    // 把可读数据 writev 到 fd, 并取走已写出的部分
+    ssize_t WriteFd(int fd, int* saveErrno);
+
+private:
+    struct Segment {
+        char* slab;
+        size_t begin;  // 可读数据开始
+        size_t end;    // 可读数据结束 (也是可写位置)
+    };
+
+    // 线程内 slab 池
+    static char* AllocSlab();
+    static void FreeSlab(char* slab);
+
+    std::deque<Segment> segs_;
+    size_t readable_{0};
+};
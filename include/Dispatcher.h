@@ -0,0 +1,65 @@
+#pragma once
+#include <netinet/in.h>
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "EventLoop.h"
+
+/**
+ * @brief 新连接分派策略: Acceptor 用它为每个连接挑选 Worker
+ * 负载来自各 EventLoop 的无锁计数 (连接数、队列深度), 只在 Acceptor 线程调用 Pick
+ */
+class Dispatcher {
+public:
+    enum class Policy {
+        RoundRobin,        // 轮询
+        LeastConnections,  // 当前连接数最少 (长连接多时分布最均匀)
+        PowerOfTwo,        // 随机挑两个, 取队列深度小的 (连接数作平局裁决)
+        ConsistentHash,    // 按客户端 IP 一致性哈希, 同一客户端落在同一 Worker (缓存局部性)
+    };
+
+    /**
+     * @param loops 参与分派的 Worker Loop
+     * @param policy 分派策略
+     * @param virtualNodes 一致性哈希每个 Worker 的虚拟节点数
+     */
+    Dispatcher(std::vector<EventLoop*> loops, Policy policy, int virtualNodes = 160);
+
+    /**
+     * @brief 为来自 peer 的连接挑选 Worker, 并计入它的连接数 (连接结束时由 Worker 调用 AddConnections(-1))
+     * @param incomingCpu 处理该连接入站包的 CPU (SO_INCOMING_CPU), 绑在该核上的 Worker 未过载时优先选它;
+     * -1 表示未知, 直接按策略挑选
+     */
+    size_t Pick(const sockaddr_in& peer, int incomingCpu = -1);
+
+    // 第 i 个 Worker 绑定的核, 用于按 incomingCpu 对齐网卡 RX 队列
+    void SetWorkerCpus(const std::vector<int>& cpus);
+
+    Policy getPolicy() const { return policy_; }
+
+    // 策略名, 用于日志
+    static std::string_view PolicyName(Policy policy);
+
+private:
+    size_t PickLeastConnections() const;
+    size_t PickPowerOfTwo();
+    size_t PickConsistentHash(uint32_t ip) const;
+
+    // 有界负载: 再给 index 分一个连接后, 不超过平均连接数的 kBoundedLoadFactor 倍
+    bool WithinBoundedLoad(size_t index) const;
+
+    uint32_t NextRandom();
+
+    std::vector<EventLoop*> loops_;
+    Policy policy_;
+    size_t next_{0};             // 轮询位置
+    uint32_t rng_{2463534242u};  // xorshift32 状态
+    // 哈希环: (哈希值, Worker 下标), 按哈希值升序
+    std::vector<std::pair<uint32_t, size_t>> ring_;
+    std::vector<int> cpuToWorker_;  // CPU 编号 -> Worker 下标, -1 表示该核上没有 Worker
+    // 一致性哈希和 RX 对齐的固定映射在 Worker 连接数超过平均值的这个倍数时让路
+    static constexpr double kBoundedLoadFactor{1.25};
+};
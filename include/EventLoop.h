@@ -1,6 +1,9 @@
 #pragma once
+#include <pthread.h>
 #include <sys/eventfd.h>
 
+#include <cerrno>
+#include <chrono>
 #include <coroutine>
 #include <functional>
 #include <iostream>
@@ -10,8 +13,34 @@
 #include <thread>
 #include <vector>
 
+#include "BufferPool.h"
+#include "Cancellation.h"
 #include "Epoll.h"
+#include "Histogram.h"
 #include "Timer.h"
+#include "WorkStealingDeque.h"
+
+class EventLoop;
+
+/**
+ * @brief 可被其他 Worker 窃取执行的任务 (见 Scheduler.h 的 Compute)
+ * run 在执行它的 Loop 线程上调用, runner 为该 Loop
+ */
+struct StealableJob {
+    void (*run)(StealableJob* job, EventLoop* runner){nullptr};
+};
+
+/**
+ * @brief 每个 Loop 的埋点统计 (开启 EventLoop::EnableInstrumentation 后记录)
+ * 直方图只由本 Loop 线程写, 其他线程可随时读取快照
+ */
+struct LoopStats {
+    Histogram iterationNs;  // 一轮处理耗时 (从 epoll_wait 返回到本轮结束, 不含阻塞等待)
+    Histogram events;       // 每次 epoll_wait 返回的事件数
+    Histogram taskWaitNs;   // 任务从 RunInLoop 投递到 ExecuteTasks 执行的排队时间
+    Histogram timerLateNs;  // 定时器比预定时间晚触发的时长
+    std::atomic<uint64_t> stalls{0};  // 超过卡顿阈值的轮数
+};
 
 /**
  * @brief EventLoop: 每个线程持有一个
@@ -22,7 +51,8 @@
  */
 class EventLoop {
 public:
-    EventLoop() {
+    // id: 所属 Worker 的编号,主线程的 Loop 为 -1
+    explicit EventLoop(int id = -1) : id_(id) {
         wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);  // 非阻塞和执行时自动关闭
         if (wakeup_fd_ == -1) {
             LOG_ERROR("eventfd error: {}", std::string(strerror(errno)));
@@ -31,7 +61,8 @@ public:
         timer_ = std::make_unique<Timer>();
     }
 
-    ~EventLoop() { close(wakeup_fd_); }
+    // 析构时再收尾一次: Loop 退出后才投递过来的恢复任务 (如另一线程完成的 Offload/Compute)
+    ~EventLoop();
 
     // 禁止拷贝
     EventLoop(const EventLoop&) = delete;
@@ -39,21 +70,82 @@ public:
 
     Epoll& GetEpoll() { return epoll_; }
 
-    // 注册等待: 当 fd 有 event 事件时,恢复 handle
-    void WaitFor(int fd, std::coroutine_handle<> handle) {
-        // 简单粗暴：每个 fd 同一时刻只能有一个协程在等
-        // 实际项目中这里需要区分 ReadHandle 和 WriteHandle
-        waiting_coroutines_[fd] = handle;
-    }
+    int GetId() const { return id_; }
+
+    // 本 Loop 的读缓冲区池 (仅在本 Loop 线程借还)
+    BufferPool& GetBufferPool() { return bufferPool_; }
+
+    /**
+     * @brief 注册等待: 当 fd 有事件时,恢复 handle
+     * 超过 opts.deadline 或 opts.token 被取消时, Loop 直接恢复协程并置 *err = ETIMEDOUT / ECANCELED
+     * (正常唤醒时 *err 不变). 返回 false 表示不能挂起 (Loop 已停止、已超时或已取消),
+     * 此时 *err 已设置, 调用方应立即恢复
+     */
+    bool WaitFor(int fd, std::coroutine_handle<> handle, int* err, const IoOptions& opts = {});
+
+    // 取消 fd 上挂起的协程: 以 *err = errCode 恢复它
+    void CancelWait(int fd, int errCode = ECANCELED);
 
     // 核心循环
     void Loop();
 
+    /**
+     * @brief 开启所有 Loop 的埋点 (在创建 Worker 之前调用):
+     * 每轮耗时、epoll 事件数、任务排队时间、定时器延迟; 一轮超过 stallThresholdMs 时记一条卡顿日志
+     */
+    static void EnableInstrumentation(int stallThresholdMs) {
+        stall_threshold_ns_.store(static_cast<int64_t>(stallThresholdMs) * 1000000,
+                                  std::memory_order_relaxed);
+        instrument_.store(true, std::memory_order_relaxed);
+    }
+    static bool IsInstrumented() { return instrument_.load(std::memory_order_relaxed); }
+    static int64_t getStallThresholdNs() {
+        return stall_threshold_ns_.load(std::memory_order_relaxed);
+    }
+
+    const LoopStats& getStats() const { return stats_; }
+
+    //* 卡顿检测 (StallDetector 在其他线程读取)
+    // 当前这轮开始的时间 (steady_clock ns), 0 表示正在 epoll_wait 或未运行
+    int64_t getIterationStartNs() const {
+        return iteration_start_ns_.load(std::memory_order_relaxed);
+    }
+    // 当前正在恢复的协程及其 fd (-1 表示在执行任务/定时器)
+    void* getCurrentCoroutine() const { return current_coroutine_.load(std::memory_order_relaxed); }
+    int getCurrentFd() const { return current_fd_.load(std::memory_order_relaxed); }
+    pthread_t getThread() const { return thread_; }
+
     void Stop() { stop_ = true; }
+    bool IsStopped() const { return stop_; }
+
+    /**
+     * @brief 停止令牌: Loop 退出后在本线程取消
+     * 挂在其他对象上的等待 (连接池、查询缓存) 用它登记取消回调, 停止时摘除并恢复协程
+     * @note 只能在本 Loop 线程注册; 注册前应先检查 IsStopped(), 已停止时不要挂起
+     */
+    CancellationToken getStopToken() const { return stopSource_.Token(); }
 
     // 添加任务到队列,并唤醒 Loop
     void RunInLoop(std::function<void()> task);
 
+    // 投递可窃取的计算任务到本 Loop 的运行队列 (仅在本 Loop 线程调用), 有空闲 Worker 时唤醒它来窃取
+    void PostJob(StealableJob* job);
+
+    // 其他 Loop 从本 Loop 的运行队列顶部窃取一个任务
+    bool StealJob(StealableJob*& job) { return runQueue_.Steal(job); }
+
+    bool IsSleeping() const { return is_sleeping_.load(std::memory_order_relaxed); }
+
+    //* 负载计数 (无锁, 供 Dispatcher 在 Acceptor 线程读取)
+    // 连接数: 分派时由 Acceptor +1, 连接结束时在本 Loop 线程 -1
+    void AddConnections(int delta) { connections_.fetch_add(delta, std::memory_order_relaxed); }
+    int getConnections() const { return connections_.load(std::memory_order_relaxed); }
+
+    // 队列深度: 尚未执行的跨线程任务 + 运行队列中的计算任务
+    int getQueueDepth() const {
+        return queued_tasks_.load(std::memory_order_relaxed) + static_cast<int>(runQueue_.Size());
+    }
+
     // 唤醒 epoll_wait
     void WakeUp() {
         uint64_t one{1UL};
@@ -63,39 +155,117 @@ public:
     // 添加定时任务接口
     void AddTimer(int id, int timeout, const TimeoutCallBack& callback) {
         if (timer_ != nullptr) timer_->add(id, timeout, callback);
+        SyncTimerCount();
     }
 
     // 更新定时任务
     void UpdateTimer(int id, int timeout, const TimeoutCallBack& callback) {
         if (timer_ != nullptr) timer_->adjust(id, timeout, callback);
+        SyncTimerCount();
     }
 
     // 删除指定 id(fd) 的定时器
     void DelTimer(int id) {
         if (timer_ != nullptr) timer_->del(id);
+        SyncTimerCount();
     }
 
+    // 定时器个数 (供其他线程读取的快照)
+    int getTimerCount() const { return timer_count_.load(std::memory_order_relaxed); }
+
+    // 分配不与 fd 冲突的定时器 id (负数),仅在本 Loop 线程调用
+    int NewTimerId() { return --next_timer_id_; }
+
 private:
-    void ExecuteTasks() {
-        std::vector<std::function<void()>> temp_tasks;
+    // 队列中的任务: enqueueNs 只在开启埋点时记录
+    struct QueuedTask {
+        std::function<void()> fn;
+        int64_t enqueueNs{0};
+    };
+
+    // 执行队列任务, 返回执行的个数
+    size_t ExecuteTasks() {
+        std::vector<QueuedTask> temp_tasks;
         {
             std::lock_guard<std::mutex> lock(mutex_);
             temp_tasks.swap(tasks_);  // 快速交换,减小锁粒度
         }
+        queued_tasks_.fetch_sub(static_cast<int>(temp_tasks.size()), std::memory_order_relaxed);
         for (auto& task : temp_tasks) {
-            task();
+            if (task.enqueueNs != 0) {
+                stats_.taskWaitNs.Record(static_cast<uint64_t>(NowNs() - task.enqueueNs));
+            }
+            task.fn();
+        }
+        return temp_tasks.size();
+    }
+
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    bool HasPendingTasks() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !tasks_.empty();
+    }
+
+    void SyncTimerCount() {
+        if (timer_ != nullptr) {
+            timer_count_.store(static_cast<int>(timer_->size()), std::memory_order_relaxed);
         }
     }
 
+    // 挂起在 fd 上的协程
+    struct Parked {
+        std::coroutine_handle<> handle;
+        int* err{nullptr};   // 超时/取消时写入错误码
+        uint64_t seq{0};     // 本次等待的序号, 防止过期的定时器/取消回调误唤醒后来的等待
+        int timerId{0};      // 截止时间定时器, 0 表示没有
+        CancellationRegistration registration;
+    };
+
+    // 运行本 Loop 的计算任务, 本地为空时持续从其他 Worker 窃取 (每轮有上限, 避免饿死 IO);
+    // 返回 true 表示因达到上限停下, 可能还有任务, 下一轮不能睡眠
+    bool RunJobs();
+
+    // 停止后收尾: 反复执行剩余任务和计算任务、取消所有等待, 直到没有新的工作
+    void Drain();
+
+    // 移出 fd 上序号为 seq 的等待 (seq 为 0 时不检查) 并恢复, errCode 非 0 时写入 *err
+    void Wake(int fd, uint64_t seq, int errCode);
+
+    int id_;
     Epoll epoll_;
     // 存储 fd -> 挂起的协程
-    std::map<int, std::coroutine_handle<>> waiting_coroutines_;
+    // 简单粗暴：每个 fd 同一时刻只能有一个协程在等
+    std::map<int, Parked> waiting_coroutines_;
+    uint64_t next_wait_seq_{0};
     std::atomic<bool> stop_{false};
+    CancellationSource stopSource_;
     int wakeup_fd_;
     std::mutex mutex_;
-    std::vector<std::function<void()>> tasks_;
+    std::vector<QueuedTask> tasks_;
     std::atomic<bool> is_sleeping_{false};
     std::unique_ptr<Timer> timer_;
+    int next_timer_id_{0};
+    BufferPool bufferPool_;
+    WorkStealingDeque<StealableJob*> runQueue_;  // 可窃取的计算任务 (Chase-Lev)
+    static constexpr int kMaxJobsPerTick{64};
+    // 负载计数各占一条缓存行: Acceptor 线程频繁读, 不与本 Loop 的热字段伪共享
+    alignas(64) std::atomic<int> connections_{0};
+    alignas(64) std::atomic<int> queued_tasks_{0};
+    std::atomic<int> timer_count_{0};  // 只由本 Loop 写
+
+    // 埋点: 开关和阈值对所有 Loop 生效
+    static inline std::atomic<bool> instrument_{false};
+    static inline std::atomic<int64_t> stall_threshold_ns_{0};
+    LoopStats stats_;
+    pthread_t thread_{};
+    alignas(64) std::atomic<int64_t> iteration_start_ns_{0};
+    std::atomic<void*> current_coroutine_{nullptr};
+    std::atomic<int> current_fd_{-1};
 };
 
 extern thread_local EventLoop* t_loop;  // TLS指针,要写在EventLoop定义之后,不然会报错
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 协程帧分配器: 每个线程按尺寸分级的空闲链表, 替代全局 operator new
+ * @details 每块内存前有 16 字节头部, 记录所属线程缓存和尺寸级别.
+ * - 本线程分配/释放: 直接操作线程内链表, 不加锁也不与其他 Worker 竞争
+ * - 跨线程释放: 压入所属线程的无锁远端栈 (CAS), 所属线程下次分配时一次性取回
+ * - 超过最大级别的帧直接走 ::operator new
+ * 线程退出后, 还有帧未释放的线程缓存由最后一个释放者回收
+ *
+ *   size class: 128 256 512 1K 2K 4K 8K (含头部)
+ */
+class FrameAllocator {
+public:
+    static constexpr size_t kHeaderSize{16UL};       // 保持 16 字节对齐
+    static constexpr size_t kMinBlock{128UL};        // 最小块
+    static constexpr int kNumClasses{7};             // 128B ~ 8KB
+    static constexpr size_t kMaxCachedBytes{1UL << 20};  // 每个级别缓存的空闲块上限 (1MB)
+
+    // 统计 (所有线程汇总)
+    struct Stats {
+        size_t liveFrames{0};    // 存活的协程帧数
+        size_t liveBytes{0};     // 存活的协程帧字节数
+        uint64_t allocs{0};      // 累计分配次数
+        uint64_t poolHits{0};    // 从空闲链表分配的次数
+        uint64_t remoteFrees{0}; // 跨线程释放次数
+    };
+
+    static void* Allocate(size_t size);
+    static void Deallocate(void* ptr) noexcept;
+
+    static Stats getStats();
+};
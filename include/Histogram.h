@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 对数-线性直方图 (HDR 风格): 每个 2 的幂区间再等分 16 个子桶, 相对误差不超过 1/16
+ * @details 小于 32 的值每个值一个桶; 更大的值按 (最高位, 其后 4 位) 定桶, 上限约 2^40 (ns 约 18 分钟),
+ * 超出的记入最后一个桶. 只由一个线程写 (普通 load+store, 没有原子读改写), 其他线程可随时读取快照
+ */
+class Histogram {
+public:
+    static constexpr int kSubBits{4};
+    static constexpr int kSubBuckets{1 << kSubBits};
+    static constexpr int kLinearMax{kSubBuckets * 2};  // 小于此值的线性区
+    static constexpr int kMaxExp{40};
+    static constexpr int kBuckets{kLinearMax + (kMaxExp - kSubBits - 1) * kSubBuckets};
+
+    static int BucketOf(uint64_t v) {
+        if (v < static_cast<uint64_t>(kLinearMax)) return static_cast<int>(v);
+        int e = std::bit_width(v) - 1;  // 最高位, >= kSubBits + 1
+        if (e >= kMaxExp) return kBuckets - 1;
+        int sub = static_cast<int>(v >> (e - kSubBits)) - kSubBuckets;
+        return kLinearMax + (e - kSubBits - 1) * kSubBuckets + sub;
+    }
+
+    // 桶的下界 (含)
+    static uint64_t LowerBound(int bucket) {
+        if (bucket < kLinearMax) return static_cast<uint64_t>(bucket);
+        int e = (bucket - kLinearMax) / kSubBuckets + kSubBits + 1;
+        uint64_t sub = static_cast<uint64_t>((bucket - kLinearMax) % kSubBuckets + kSubBuckets);
+        return sub << (e - kSubBits);
+    }
+
+    // 桶的上界 (不含)
+    static uint64_t UpperBound(int bucket) {
+        return bucket + 1 < kBuckets ? LowerBound(bucket + 1) : LowerBound(bucket) * 2;
+    }
+
+    //* 只由所属线程调用
+    void Record(uint64_t v) {
+        Bump(counts_[BucketOf(v)], 1);
+        Bump(count_, 1);
+        Bump(sum_, v);
+        if (v > max_.load(std::memory_order_relaxed)) {
+            max_.store(v, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 可合并的快照: 抓取时把各线程的直方图相加后计算分位数
+     */
+    struct Snapshot {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(kBuckets, 0);
+        uint64_t count{0};
+        uint64_t sum{0};
+        uint64_t max{0};
+
+        void Merge(const Snapshot& other) {
+            for (int i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+            count += other.count;
+            sum += other.sum;
+            max = std::max(max, other.max);
+        }
+
+        // 分位数 q (0~1): 返回所在桶的中点, 不超过最大值
+        uint64_t Percentile(double q) const {
+            if (count == 0) return 0;
+            auto rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < kBuckets; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    uint64_t mid = (LowerBound(i) + UpperBound(i) - 1) / 2;
+                    return std::min(mid, max);
+                }
+            }
+            return max;
+        }
+    };
+
+    // 累加到 out (读取期间所属线程可能仍在写, 各桶是各自的近似值)
+    void AddTo(Snapshot& out) const {
+        for (int i = 0; i < kBuckets; ++i) out.counts[i] += counts_[i].load(std::memory_order_relaxed);
+        out.count += count_.load(std::memory_order_relaxed);
+        out.sum += sum_.load(std::memory_order_relaxed);
+        out.max = std::max(out.max, max_.load(std::memory_order_relaxed));
+    }
+
+private:
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @brief 按路由 / 阶段记录延迟 (ns): 每个线程一组直方图, 抓取或退出时合并
+ * 路由需在 Worker 处理请求之前注册 (之后只读, 查找不加锁); 未注册的路径记在 "other" 下
+ */
+class RouteLatency {
+public:
+    enum Phase : int {
+        kParse,       // 解析请求
+        kHandler,     // 业务处理 (含数据库)
+        kDbWait,      // 等待数据库连接 (Acquire, 含排队)
+        kDbQuery,     // 数据库查询: 交给 BlockingPool 的排队 + prepare/执行/取结果
+        kLastByte,    // 从开始解析到响应最后一个字节发出
+        kPhaseNum,
+    };
+
+    // 注册路由, 返回其编号 (重复注册返回已有编号)
+    static int Register(std::string_view route);
+
+    // 路径对应的路由编号, 未注册时为 "other"
+    static int Find(std::string_view path);
+
+    // 记录一次耗时 (只写本线程的直方图)
+    static void Record(int route, Phase phase, uint64_t ns);
+
+    // 合并所有线程的直方图
+    static Histogram::Snapshot Merge(int route, Phase phase);
+
+    // Prometheus summary 格式 (秒): p50/p90/p99/p999 + _sum + _count
+    static std::string Render();
+
+    // 便于阅读的表格 (ms), 用于退出时写日志
+    static std::string Dump();
+};
@@ -79,10 +79,12 @@ private:
     static int ConverHex(char ch);
 
     ParseState state_{REQUEST_LINE};
-    std::string_view method_{};
-    std::string_view path_{};
-    std::string_view version_{};
+    //! 请求行和头部必须持有自己的内存: Parse 中的 line 是临时 string,
+    //! 用 string_view 引用它会在解析结束后悬空
+    std::string method_{};
+    std::string path_{};
+    std::string version_{};
     std::string body_{};
-    std::unordered_map<std::string_view, std::string_view> headers_{};
+    std::unordered_map<std::string, std::string> headers_{};
     std::unordered_map<std::string, std::string> post_{};
 };
\ No newline at end of file
@@ -6,7 +6,7 @@
 #include <string>
 #include <unordered_map>
 
-#include "Buffer.h"
+#include "ChainBuffer.h"
 
 /**
  * @brief Http响应类
@@ -32,16 +32,28 @@ public:
         srcDir_ = srcDir;
         fileFd_ = -1;
         mmFileStat_ = {0};
+        body_.clear();
+        hasBody_ = false;
     }
 
-    // 核心: 构建响应报文写入 Buffer, Content(即html文件)传输到 clientFd
-    void MakeResponse(Buffer& buf, int clientFd);
+    // 内存中生成的响应体 (如 /metrics): 随响应头一起 writev, 不读文件
+    void InitContent(std::string body, const std::string& contentType, bool isKeepAlive = false,
+                     int code = 200) {
+        std::string path;
+        Init("", path, isKeepAlive, code);
+        body_ = std::move(body);
+        contentType_ = contentType;
+        hasBody_ = true;
+    }
+
+    // 核心: 构建响应报文写入 ChainBuffer (由 writev 直接发出), Content(即html文件)传输到 clientFd
+    void MakeResponse(ChainBuffer& buf, int clientFd);
 
     // 获取文件的 Mime Type(如 .html -> text/html)
     std::string GetFileType(const std::string& name);
 
     // 生成默认错误页面
-    void ErrorContent(Buffer& buf, std::string message);
+    void ErrorContent(ChainBuffer& buf, std::string message);
 
     int getCode() const { return code_; }
 
@@ -50,9 +62,9 @@ public:
     off_t getFileSize() const { return mmFileStat_.st_size; }
 
 private:
-    void AddStateLine(Buffer& buf);
-    void AddHeader(Buffer& buf);
-    void AddContent(Buffer& buf, int clientFd);  // Content即为静态html资源,采用sendfile
+    void AddStateLine(ChainBuffer& buf);
+    void AddHeader(ChainBuffer& buf);
+    void AddContent(ChainBuffer& buf, int clientFd);  // Content即为静态html资源,采用sendfile
 
     ssize_t SendFile(int inFd);  // 封装sendfile
 
@@ -66,4 +78,8 @@ private:
     struct stat mmFileStat_;  // 文件状态信息
 
     bool isKeepAlive_;
+
+    std::string body_;  // InitContent 设置的响应体
+    std::string contentType_;
+    bool hasBody_{false};
 };
\ No newline at end of file
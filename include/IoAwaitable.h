@@ -13,31 +13,33 @@
 struct IoAwaitable {
     int fd;
     uint32_t event_type;  // EPOLLIN 或 EPOLLOUT
-    // 暂存 IO 操作的结果
-    ssize_t result{0L};
+    IoOptions opts{};     // 截止时间 / 取消令牌
+    int err{0};           // 超时 (ETIMEDOUT) 或取消 (ECANCELED) 时由 EventLoop 写入
 
     // 1. 总是挂起(简单起见,我们假设总是需要等 Epoll,除非是 Reactor 优化)
     bool await_ready() { return false; }
 
-    // 2. 挂起时的操作
-    void await_suspend(std::coroutine_handle<> hd) {
+    // 2. 挂起时的操作: 返回 false 表示已超时/已取消,不挂起
+    bool await_suspend(std::coroutine_handle<> hd) {
+        if (t_loop == nullptr) {
+            return false;
+        }
         // 将 fd 和当前协程句柄 hd 注册到调度器
-        if (t_loop != nullptr) {
-            t_loop->WaitFor(fd, hd);
-
-            // 将 fd 注册到 Epoll
-            try {
-                t_loop->GetEpoll().Mod(fd, event_type | EPOLLET);
-            } catch (...) {
-                // 如果时第一次加,Mod 会失败,改为 Add
-                t_loop->GetEpoll().Add(fd, event_type | EPOLLET);
-            }
+        if (!t_loop->WaitFor(fd, hd, &err, opts)) {
+            return false;
         }
+        // 将 fd 注册到 Epoll
+        try {
+            t_loop->GetEpoll().Mod(fd, event_type | EPOLLET);
+        } catch (...) {
+            // 如果时第一次加,Mod 会失败,改为 Add
+            t_loop->GetEpoll().Add(fd, event_type | EPOLLET);
+        }
+        return true;
     }
+
     // 3. 唤醒后的操作
-    // 这里我们不做实际的 read/write，只返回 io 结果的占位符
-    // 或者，更常见的做法：await_resume 里不做 IO，
-    // 而是让协程醒来后自己在 Socket 方法里做 IO。
-    // 我们采用后者：只负责唤醒，不负责读写数据。
-    void await_resume() {}
+    // 只负责唤醒，不负责读写数据: 让协程醒来后自己在 Socket 方法里做 IO。
+    // 返回 0 表示 fd 就绪, 否则为 ETIMEDOUT / ECANCELED
+    int await_resume() { return err; }
 };
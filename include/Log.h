@@ -1,25 +1,51 @@
 #pragma once
-#include <assert.h>
-#include <fmt/chrono.h>
 #include <fmt/core.h>
-#include <stdarg.h>  //for va_start
+#include <fmt/format.h>
 #include <string.h>
 #include <sys/stat.h>  //for mkdir
 #include <sys/time.h>
+#include <time.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
-#include "BlockQueue.h"
-#include "Buffer.h"
+#include "MpmcQueue.h"
+#include "LogRing.h"
 
+/**
+ * @brief 线程缓冲区满 (刷盘跟不上) 时的处理方式, 业务线程都不会等待磁盘
+ */
+enum class OverflowPolicy {
+    DROP,            // 直接丢弃并计数
+    DROP_LOW_LEVEL,  // 按级别提前丢弃: DEBUG 超过 50%, INFO 超过 75%, WARN 超过 90%, ERROR 满时才丢
+    BLOCK_TIMEOUT,   // 唤醒刷盘线程并等待空间, 超时后丢弃 (EventLoop 线程不等待, 按 DROP 处理)
+    SAMPLE,          // 超过一半后每 sampleRate 条保留一条, 满时丢弃
+};
+
+/**
+ * @brief 异步日志
+ * @details 业务线程把格式化好的日志写入自己独占的 SPSC 环形缓冲区 (无锁, 无系统调用),
+ * 后台刷盘线程定期收集所有线程的缓冲区, 用一次 writev 批量写入文件.
+ * 延迟格式化模式下业务线程只写入二进制记录 (格式串指针 + 参数字节), 格式化由刷盘线程完成;
+ * 此时格式串必须是字符串字面量 (LOG_* 宏的用法), 不能是 fmt::runtime 的临时字符串
+ */
 class Log {
 public:
     // 初始化日志实例
     // level:  0=DEBUG  1=INFO  2=WARN  3=ERROR
+    // maxQueueCapacity: 每个线程缓冲的日志行数 (按每行 256 字节换算为缓冲区大小), 0 表示同步写
+    // deferred: 延迟格式化 (需开启异步), 只在第一次启动刷盘线程时生效
     void Init(int level = 1, const char* path = "./log", const char* suffix = ".log",
-              int maxQueueCapacity = 1024);
+              int maxQueueCapacity = 1024, bool deferred = false);
 
     static Log* getInstance() {
         static Log instance;
@@ -34,42 +60,53 @@ public:
     void Write(int level, fmt::format_string<Args...> format, Args&&... args) {
         struct timeval now = {0, 0};
         gettimeofday(&now, nullptr);
-        time_t tSec = now.tv_sec;
-        struct tm* sysTime = localtime(&tSec);
 
-        std::string levelStr = LevelToString(level);
+        //* 延迟格式化模式: 只拷贝格式串指针与参数的原始字节, 由刷盘线程格式化
+        if (deferred_.load(std::memory_order_relaxed)) {
+            WriteDeferred(level, now, fmt::string_view(format), args...);
+            return;
+        }
 
-        std::string logLine{};
+        //* 1. 格式化到线程局部缓冲区, 容量够时不分配内存
+        thread_local fmt::memory_buffer logLine;
+        logLine.clear();
         try {
-            //* 1. 格式化用户内容
-            std::string content = fmt::format(format, std::forward<Args>(args)...);
-
-            //* 2. 加上前缀
-            logLine = fmt::format("[{}] {}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}.{:06d} {}\n",
-                                  levelStr, sysTime->tm_year + 1900, sysTime->tm_mon + 1,
-                                  sysTime->tm_mday, sysTime->tm_hour, sysTime->tm_min,
-                                  sysTime->tm_sec, (int)now.tv_usec, content);
+            FormatPrefix(logLine, level, now);
+            fmt::format_to(std::back_inserter(logLine), format, std::forward<Args>(args)...);
         } catch (const std::exception& e) {
-            logLine = fmt::format("[ERROR] Log Format Error: {}\n", e.what());
+            logLine.clear();
+            fmt::format_to(std::back_inserter(logLine), "[ERROR] Log Format Error: {}", e.what());
         }
+        logLine.push_back('\n');
 
-        //* 3. 推入异步队列
-        if (isAsync_ && deque_ != nullptr && !deque_->full()) {
-            deque_->push_back(std::move(logLine));
-        } else {
-            // 同步写 (如果没开异步或队列满)
-            std::lock_guard<std::mutex> lock(mutex_);
-            fputs(logLine.c_str(), fp_);
-            // 同步模式下强制刷盘
-            fflush(fp_);
-        }
+        //* 2. 写入本线程的环形缓冲区
+        Append(level, logLine.data(), logLine.size());
     }
 
-    // 把缓冲区里的数据刷到磁盘
+    // 把所有线程缓冲区里的数据写入文件 (等待刷盘线程完成一轮)
     void Flush();
 
-    int getLevel() { return level_; }
-    void setLevel(int level) { level_ = level; }
+    /**
+     * @brief 日志切分: 行数或字节数超限、跨天时切换到新文件, 旧文件由低优先级线程压缩为 .gz
+     * 文件名为 path/YYYY_MM_DD.log, 同一天的后续文件为 path/YYYY_MM_DD-N.log
+     * @param maxLines/maxBytes 单个文件上限, 0 表示不限制
+     */
+    void SetRotate(int maxLines = MAX_LINES_, size_t maxBytes = MAX_BYTES_, bool compress = true);
+
+    // 溢出策略, 应在写日志之前设置; blockTimeoutUs 用于 BLOCK_TIMEOUT, sampleRate 用于 SAMPLE
+    //! BLOCK_TIMEOUT 只在非 Loop 线程 (辅助线程、主线程初始化) 上等待; EventLoop 线程满时直接丢弃
+    void SetOverflowPolicy(OverflowPolicy policy, int blockTimeoutUs = 1000, int sampleRate = 10);
+
+    // 因缓冲区溢出丢弃的日志条数 (刷盘线程每秒把新增的丢弃数写入日志)
+    uint64_t getDroppedCount();
+
+    int getLevel() { return level_.load(std::memory_order_relaxed); }
+    void setLevel(int level) { level_.store(level, std::memory_order_relaxed); }
+
+    // 运行期级别判断: 静态原子变量, 不经过 getInstance() 的局部静态变量检查
+    static bool IsLevelEnabled(int level) {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
 
     bool isOpen() { return isOpen_; }
 
@@ -92,10 +129,130 @@ private:
         }
     }
 
-    void AsyncWrite();  // 真正的写盘逻辑
+    /**
+     * @brief 延迟格式化的二进制记录头, 后面紧跟编码后的参数
+     * 字符串参数编码为 uint32 长度 + 字节; 数值/指针拷贝原始字节; 其他类型在写入时先格式化成字符串
+     */
+    using DecodeFn = void (*)(fmt::memory_buffer& out, fmt::string_view format, const char* args);
+    struct LogRecord {
+        uint32_t len;  // 整条记录字节数 (含头部)
+        int32_t level;
+        int64_t sec;
+        int64_t usec;
+        DecodeFn decode;     // 按参数类型实例化的解码函数
+        const char* format;  // 格式串 (字面量, 静态存储期)
+        size_t formatLen;
+    };
+
+    // 参数在记录中的存储方式: 字符串 / 原始字节 / 预先格式化
+    template <typename T>
+    static constexpr bool IsStringArg = std::is_convertible_v<const T&, std::string_view>;
+    template <typename T>
+    static constexpr bool IsRawArg = std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                                     std::is_same_v<T, const void*> || std::is_same_v<T, void*>;
+    // 解码后传给 fmt 的类型
+    template <typename T>
+    using DecodedArg = std::conditional_t<IsRawArg<T>, T, std::string_view>;
+
+    template <typename... Args>
+    void WriteDeferred(int level, const struct timeval& now, fmt::string_view format,
+                       const Args&... args) {
+        thread_local fmt::memory_buffer record;
+        record.clear();
+        LogRecord head{0, level, now.tv_sec, now.tv_usec, &Decode<std::decay_t<Args>...>,
+                       format.data(), format.size()};
+        record.append(reinterpret_cast<const char*>(&head),
+                      reinterpret_cast<const char*>(&head) + sizeof(head));
+        (EncodeArg(record, args), ...);
+        uint32_t len = static_cast<uint32_t>(record.size());
+        memcpy(record.data(), &len, sizeof(len));
+        Append(level, record.data(), record.size());
+    }
+
+    static void EncodeString(fmt::memory_buffer& out, std::string_view str) {
+        uint32_t n = static_cast<uint32_t>(str.size());
+        out.append(reinterpret_cast<const char*>(&n), reinterpret_cast<const char*>(&n) + sizeof(n));
+        out.append(str.data(), str.data() + n);
+    }
+
+    template <typename T>
+    static void EncodeArg(fmt::memory_buffer& out, const T& arg) {
+        using D = std::decay_t<T>;
+        if constexpr (IsRawArg<D>) {
+            D value = arg;
+            out.append(reinterpret_cast<const char*>(&value),
+                       reinterpret_cast<const char*>(&value) + sizeof(value));
+        } else if constexpr (std::is_pointer_v<T> && IsStringArg<D>) {
+            EncodeString(out, arg != nullptr ? std::string_view(arg) : std::string_view("(null)"));
+        } else if constexpr (IsStringArg<D>) {
+            EncodeString(out, std::string_view(arg));
+        } else {
+            //! 其他类型可能引用临时对象, 只能在写入时格式化
+            fmt::memory_buffer tmp;
+            fmt::format_to(std::back_inserter(tmp), "{}", arg);
+            EncodeString(out, std::string_view(tmp.data(), tmp.size()));
+        }
+    }
+
+    template <typename T>
+    static DecodedArg<T> DecodeArg(const char*& args) {
+        if constexpr (IsRawArg<T>) {
+            T value;
+            memcpy(&value, args, sizeof(value));
+            args += sizeof(value);
+            return value;
+        } else {
+            uint32_t n = 0;
+            memcpy(&n, args, sizeof(n));
+            std::string_view str(args + sizeof(n), n);
+            args += sizeof(n) + n;
+            return str;
+        }
+    }
+
+    // 刷盘线程: 按写入时的参数类型解码并格式化
+    template <typename... Args>
+    static void Decode(fmt::memory_buffer& out, fmt::string_view format, const char* args) {
+        //! 花括号初始化保证按参数顺序求值
+        std::tuple<DecodedArg<Args>...> values{DecodeArg<Args>(args)...};
+        std::apply(
+                [&](auto&... value) {
+                    fmt::vformat_to(std::back_inserter(out), format,
+                                    fmt::make_format_args(value...));
+                },
+                values);
+    }
+
+    void FormatPrefix(fmt::memory_buffer& out, int level, const struct timeval& now);
+    void FormatRecord(const char* record, fmt::memory_buffer& out);  // 二进制记录 -> 文本行
+
+    void Append(int level, const char* data, size_t len);  // 写入本线程缓冲区, 满时按溢出策略处理
+    LogRing* LocalRing();                       // 本线程的缓冲区, 首次调用时注册
+    void WakeFlusher();
+    bool PushWithPolicy(LogRing* ring, int level, const char* data, size_t len);
+    void ReportDropped();  // 刷盘线程: 记录新增的丢弃数
+
+    void AsyncWrite();  // 真正的写盘逻辑 (后台线程)
+    void DrainRings();  // 收集所有缓冲区并批量写盘
+    void DrainRecords(const std::vector<std::shared_ptr<LogRing>>& rings);  // 延迟格式化模式
+    void WriteSync(const char* data, size_t len);
 
-    int level_;
-    bool isAsync_{false};
+    // 切分: 只在刷盘线程 (同步模式下为写日志的线程) 调用, 新文件打开后才短暂持锁替换 fd
+    void MaybeRotate();
+    void Rotate(const struct tm& day, int index);
+    std::string SegmentName(const struct tm& day, int index) const;
+    int LastSegment(const struct tm& day) const;  // 当天已有的最后一个文件序号
+    int OpenSegment(const std::string& name);
+    void Account(size_t bytes, size_t lines);  // 持 mutex_ 调用
+
+    static void CompressThread();  // 压缩线程入口
+    void CompressLoop();
+    static bool CompressFile(const std::string& name);
+
+    static inline std::atomic<int> level_{1};
+    //* 以下开关在业务线程上读取, 可能被 Init/Close/SetOverflowPolicy 同时修改
+    std::atomic<bool> isAsync_{false};
+    std::atomic<bool> deferred_{false};  // 延迟格式化模式
     bool isOpen_;
 
     // 日志路径和文件名
@@ -105,31 +262,74 @@ private:
     static const int LOG_NAME_LEN{256};
     static const int LOG_PATH_LEN{256};
     static const int MAX_LINES_{50000};
+    static const size_t MAX_BYTES_{64 << 20};
+    static const int FLUSH_INTERVAL_MS_{10};  // 刷盘线程的最长等待时间
 
-    int maxLines{0};
+    // 切分状态 (lineCount_/bytes_ 由 mutex_ 保护, 其余由 rotateMutex_ 保护)
+    int maxLines_{MAX_LINES_};
+    size_t maxBytes_{MAX_BYTES_};
+    bool compress_{true};
     int lineCount_{0};
+    size_t bytes_{0};
     int toDay_{0};
+    int segment_{0};           // 当天的文件序号
+    std::string fileName_;     // 当前文件
+    time_t dayCheckSec_{0};    // 上次检查日期的时间 (每秒检查一次)
+    std::mutex rotateMutex_;
+
+    // 压缩线程: 待压缩的旧文件名
+    std::unique_ptr<MpmcQueue<std::string>> compressQueue_{nullptr};
+    std::unique_ptr<std::thread> compressThread_{nullptr};
+
+    size_t ringCapacity_{0};  // 每个线程的缓冲区字节数
+
+    // 刷盘线程使用: 格式化输出与记录拷贝
+    fmt::memory_buffer flushBuffer_;
+    std::vector<char> recordBuffer_;
 
-    Buffer buffer_;  // 日志缓冲
+    // 所有线程的缓冲区 (线程退出后由刷盘线程在读空后移除)
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+
+    // 溢出策略与丢弃统计
+    std::atomic<OverflowPolicy> overflow_{OverflowPolicy::DROP_LOW_LEVEL};
+    std::atomic<int> blockTimeoutUs_{1000};
+    std::atomic<uint32_t> sampleRate_{10};
+    uint64_t retiredDropped_{0};  // 已回收缓冲区的丢弃数 (ringsMutex_ 保护)
+    uint64_t reportedDropped_{0};
+    time_t dropReportSec_{0};
+
+    // 刷盘线程的唤醒与 Flush 同步
+    std::mutex flushMutex_;
+    std::condition_variable flushCv_;
+    std::condition_variable flushDoneCv_;
+    bool wakeup_{false};
+    bool stop_{false};
+    uint64_t flushReq_{0};   // Flush 请求序号
+    uint64_t flushDone_{0};  // 已完成的 Flush 序号
 
-    // 更高效：双缓冲区 (Double Buffering)
-    // 今天先用简单的 BlockQueue<std::string>
-    std::unique_ptr<BlockQueue<std::string>> deque_{nullptr};
     std::unique_ptr<std::thread> writeThread_{nullptr};
-    std::mutex mutex_;
+    std::mutex mutex_;  // 同步写
 
-    FILE* fp_{nullptr};
+    int fd_{-1};
 };
 
-// 宏定义简化调用
-#define LOG_DEBUG(format, ...) \
-    if (Log::getInstance()->getLevel() == 0) Log::getInstance()->Write(0, format, ##__VA_ARGS__)
+// 编译期最低级别 (由 CMake 选项 LOG_MIN_LEVEL 设置): 低于它的 LOG_* 调用不生成任何代码
+#ifndef LOG_ACTIVE_LEVEL
+#define LOG_ACTIVE_LEVEL 0
+#endif
 
-#define LOG_INFO(format, ...) \
-    if (Log::getInstance()->getLevel() <= 1) Log::getInstance()->Write(1, format, ##__VA_ARGS__);
-
-#define LOG_WARN(format, ...) \
-    if (Log::getInstance()->getLevel() <= 2) Log::getInstance()->Write(2, format, ##__VA_ARGS__);
+// 宏定义简化调用
+#define LOG_BASE(level, format, ...)                                                \
+    do {                                                                            \
+        if constexpr ((level) >= LOG_ACTIVE_LEVEL) {                                \
+            if (Log::IsLevelEnabled(level)) {                                       \
+                Log::getInstance()->Write(level, format, ##__VA_ARGS__);            \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
 
-#define LOG_ERROR(format, ...) \
-    if (Log::getInstance()->getLevel() <= 3) Log::getInstance()->Write(3, format, ##__VA_ARGS__);
+#define LOG_DEBUG(format, ...) LOG_BASE(0, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOG_BASE(1, format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) LOG_BASE(2, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG_BASE(3, format, ##__VA_ARGS__)
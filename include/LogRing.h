@@ -0,0 +1,103 @@
+#pragma once
+#include <sys/uio.h>  // iovec
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief 单生产者单消费者 (SPSC) 无锁字节环形缓冲区
+ * @details 生产者是写日志的业务线程 (每个线程独占一个), 消费者是后台刷盘线程.
+ * head_/tail_ 只增不减, 分别只由消费者/生产者修改, 各占一个缓存行避免伪共享;
+ * 生产者缓存一份 head_, 只有空间看起来不够时才去读消费者的缓存行
+ */
+class LogRing {
+public:
+    // capacity 向上取整为 2 的幂
+    explicit LogRing(size_t capacity) {
+        size_t cap = 1024;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        buf_ = std::make_unique<char[]>(cap);
+    }
+
+    // 禁止拷贝
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // 生产者: 写入一整条记录, 空间不足返回 false (不会写入半条)
+    bool Push(const char* data, size_t len) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (len > Capacity() - (tail - cachedHead_)) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (len > Capacity() - (tail - cachedHead_)) {
+                return false;
+            }
+        }
+        size_t pos = tail & mask_;
+        size_t first = std::min(len, Capacity() - pos);
+        std::memcpy(buf_.get() + pos, data, first);
+        std::memcpy(buf_.get(), data + first, len - first);  // 环绕部分
+        tail_.store(tail + len, std::memory_order_release);
+        return true;
+    }
+
+    // 生产者: 已用空间是否超过 bytes (用于提前唤醒刷盘线程和溢出策略)
+    bool Exceeds(size_t bytes) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ <= bytes) {
+            return false;
+        }
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        return tail - cachedHead_ > bytes;
+    }
+
+    // 消费者: 取出当前可读数据 (环绕时为两段), 返回字节数
+    size_t Peek(struct iovec* vec, int* cnt) const {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t n = tail_.load(std::memory_order_acquire) - head;
+        size_t pos = head & mask_;
+        size_t first = std::min(n, Capacity() - pos);
+        *cnt = 0;
+        if (first > 0) {
+            vec[(*cnt)++] = {buf_.get() + pos, first};
+        }
+        if (n > first) {
+            vec[(*cnt)++] = {buf_.get(), n - first};
+        }
+        return n;
+    }
+
+    // 消费者: 从可读数据的 offset 处拷贝 len 字节到 dst (处理环绕), 调用方保证范围有效
+    void CopyOut(size_t offset, void* dst, size_t len) const {
+        size_t pos = (head_.load(std::memory_order_relaxed) + offset) & mask_;
+        size_t first = std::min(len, Capacity() - pos);
+        std::memcpy(dst, buf_.get() + pos, first);
+        std::memcpy(static_cast<char*>(dst) + first, buf_.get(), len - first);
+    }
+
+    // 消费者: 释放已写盘的 len 字节
+    void Consume(size_t len) {
+        head_.store(head_.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    size_t Size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t Capacity() const { return mask_ + 1; }
+
+    std::atomic<bool> closed{false};    // 所属线程已退出, 读空后由刷盘线程回收
+    std::atomic<bool> notified{false};  // 已唤醒过刷盘线程, 读空后复位
+    std::atomic<uint64_t> dropped{0};   // 溢出丢弃的记录数, 只由生产者增加
+    uint32_t sampleSeq{0};              // 采样计数, 只由生产者使用
+
+private:
+    std::unique_ptr<char[]> buf_;
+    size_t mask_{0};
+
+    alignas(64) std::atomic<size_t> head_{0};  // 读位置, 只由消费者修改
+    alignas(64) std::atomic<size_t> tail_{0};  // 写位置, 只由生产者修改
+    size_t cachedHead_{0};                     // 生产者缓存的读位置
+};
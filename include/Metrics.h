@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 运行指标: 每线程计数 + 抓取时汇总, 以 Prometheus 文本格式输出
+ * @details 热路径只写本线程的计数块 (独占缓存行, 普通 load+store, 没有原子读改写),
+ * 不同线程之间没有共享缓存行的写入. Render() 遍历所有线程的计数块求和, 已退出线程的计数
+ * 在退出时并入累计值. 由其他组件维护的量 (每个 Loop 的连接数、队列深度、日志丢弃数等)
+ * 通过 Register 注册读取函数, 抓取时调用
+ */
+class Metrics {
+public:
+    enum Counter : int {
+        kAcceptedConnections,  // Acceptor 接受的连接
+        kRequests,             // 处理的请求
+        kStatus2xx,            // 按状态码分类的响应
+        kStatus3xx,
+        kStatus4xx,
+        kStatus5xx,
+        kBytesWritev,    // writev 发出的字节 (响应头 / 内存中的响应体)
+        kBytesSendfile,  // sendfile 发出的字节 (静态文件)
+        kDbWaits,        // 等待数据库连接的次数
+        kDbWaitNs,       // 等待数据库连接的累计时间
+        kCounterNum,
+    };
+
+    enum class Type { Counter, Gauge };
+
+    // 计数 +n (只写本线程的计数块)
+    static void Add(Counter counter, uint64_t n = 1);
+
+    // 记录一个响应: 请求数 +1, 并按状态码分类
+    static void CountResponse(int code);
+
+    /**
+     * @brief 注册抓取时读取的指标
+     * @param family 指标名, 同名的多条按注册顺序归为一组
+     * @param labels 标签, 如 loop="0", 可为空
+     * @param read 读取函数, 在抓取线程上调用, 必须线程安全
+     */
+    static void Register(const std::string& family, const std::string& help, Type type,
+                         const std::string& labels, std::function<int64_t()> read);
+
+    // 直方图快照: counts[i] 为落在第 i 个桶的样本数 (不累计), 比 bounds 多一个 +Inf 桶
+    struct HistogramSample {
+        std::vector<uint64_t> counts;
+        double sum{0.0};
+    };
+
+    /**
+     * @brief 注册直方图, 按 Prometheus histogram 输出 _bucket{le=...} / _sum / _count
+     * @param bounds 各桶上限 (升序), 单位与 sum 一致
+     */
+    static void RegisterHistogram(const std::string& family, const std::string& help,
+                                  std::vector<double> bounds,
+                                  std::function<HistogramSample()> read);
+
+    // 汇总所有线程的计数和注册的指标
+    static std::string Render();
+
+    // 单个计数的汇总值
+    static uint64_t Get(Counter counter);
+};
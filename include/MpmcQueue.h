@@ -0,0 +1,281 @@
+#pragma once
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief 有界无锁多生产者多消费者队列 (Dmitry Vyukov 的环形数组算法)
+ * @details 每个槽位带一个序号: 序号 == 位置 表示可写, 序号 == 位置 + 1 表示可读,
+ * 生产者/消费者各自 CAS 抢占位置, 互不加锁. 槽位和两个位置计数器都按缓存行对齐.
+ * 只有队列空 (pop) 或满 (push_back) 时才通过 futex 睡眠, 没有等待者时不会发起唤醒系统调用.
+ * 接口与 BlockQueue 对齐 (push_back / pop / pop(item, timeout) / shutdown), 另外提供
+ * 非阻塞的 try_push / try_pop 和批量的 push_n / pop_n
+ * @tparam T 元素类型, 需可移动
+ */
+template <typename T>
+class MpmcQueue {
+public:
+    // 容量向上取整为 2 的幂
+    explicit MpmcQueue(size_t maxCapacity = 1024) {
+        if (maxCapacity == 0) {
+            throw std::runtime_error("MaxCapacity must > 0");
+        }
+        size_t cap = 2;
+        while (cap < maxCapacity) cap <<= 1;
+        mask_ = cap - 1;
+        cells_ = new Cell[cap];
+        for (size_t i = 0; i < cap; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 禁止拷贝
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    ~MpmcQueue() {
+        shutdown();
+        T item;
+        while (try_pop(item)) {
+        }
+        delete[] cells_;
+    }
+
+    //* 非阻塞接口: 满/空时立即返回 false
+    bool try_push(T&& item) { return push_n(&item, 1) == 1; }
+    bool try_push(const T& item) {
+        T copy(item);
+        return try_push(std::move(copy));
+    }
+    bool try_pop(T& item) { return pop_n(&item, 1) == 1; }
+
+    /**
+     * @brief 批量入队: 一次 CAS 抢占连续的若干槽位, 元素被移动走
+     * @return 实际入队的个数 (队列剩余空间不足时小于 n)
+     */
+    size_t push_n(T* items, size_t n) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (true) {
+            // 数出从 pos 开始连续可写的槽位
+            count = 0;
+            bool stale = false;
+            while (count < n) {
+                size_t seq = cells_[(pos + count) & mask_].seq.load(std::memory_order_acquire);
+                intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + count);
+                if (dif == 0) {
+                    ++count;
+                } else {
+                    stale = dif > 0;  // 该槽位已被其他生产者写过, pos 过期
+                    break;
+                }
+            }
+            if (count == 0) {
+                if (!stale) return 0;  // 队列满
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (enqueuePos_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Cell& cell = cells_[(pos + i) & mask_];
+            new (cell.storage) T(std::move(items[i]));
+            cell.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        Notify(notEmpty_, consumerWaiters_);
+        return count;
+    }
+
+    /**
+     * @brief 批量出队: 最多取 n 个到 items
+     * @return 实际出队的个数 (队列为空时为 0)
+     */
+    size_t pop_n(T* items, size_t n) {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (true) {
+            count = 0;
+            bool stale = false;
+            while (count < n) {
+                size_t seq = cells_[(pos + count) & mask_].seq.load(std::memory_order_acquire);
+                intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + count + 1);
+                if (dif == 0) {
+                    ++count;
+                } else {
+                    stale = dif > 0;  // 该槽位已被其他消费者取走, pos 过期
+                    break;
+                }
+            }
+            if (count == 0) {
+                if (!stale) return 0;  // 队列空
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (dequeuePos_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Cell& cell = cells_[(pos + i) & mask_];
+            T* ptr = std::launder(reinterpret_cast<T*>(cell.storage));
+            items[i] = std::move(*ptr);
+            ptr->~T();
+            cell.seq.store(pos + i + mask_ + 1, std::memory_order_release);  // 下一圈可写
+        }
+        Notify(notFull_, producerWaiters_);
+        return count;
+    }
+
+    //* 阻塞接口: 满时睡眠等待; 已 shutdown 返回 false
+    bool push_back(T&& item) {
+        while (true) {
+            if (shutdown_.load(std::memory_order_acquire)) return false;
+            if (try_push(std::move(item))) return true;
+            uint32_t ticket = notFull_.load(std::memory_order_acquire);
+            if (Wait(notFull_, ticket, producerWaiters_, [&]() { return try_push(std::move(item)); },
+                     -1)) {
+                return true;
+            }
+        }
+    }
+    bool push_back(const T& item) {
+        T copy(item);
+        return push_back(std::move(copy));
+    }
+
+    // 阻塞版本: 队列为空时一直等待; shutdown 后取完剩余元素返回 false
+    bool pop(T& item) { return pop(item, -1); }
+
+    // 超时弹出 (毫秒, -1 表示一直等待)
+    bool pop(T& item, int timeout) {
+        timespec deadline{};
+        if (timeout >= 0) {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += timeout / 1000;
+            deadline.tv_nsec += (timeout % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+        }
+        while (true) {
+            if (try_pop(item)) return true;
+            if (shutdown_.load(std::memory_order_acquire)) {
+                return try_pop(item);  // shutdown 之前入队的元素
+            }
+            long remainNs = -1;
+            if (timeout >= 0) {
+                timespec now{};
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                remainNs = (deadline.tv_sec - now.tv_sec) * 1000000000L +
+                           (deadline.tv_nsec - now.tv_nsec);
+                if (remainNs <= 0) return false;
+            }
+            uint32_t ticket = notEmpty_.load(std::memory_order_acquire);
+            if (Wait(notEmpty_, ticket, consumerWaiters_, [&]() { return try_pop(item); },
+                     remainNs)) {
+                return true;
+            }
+        }
+    }
+
+    // 关闭队列: 唤醒所有等待者, 之后 push_back 失败, pop 取完剩余元素后返回 false
+    void shutdown() {
+        shutdown_.store(true, std::memory_order_release);
+        notEmpty_.fetch_add(1, std::memory_order_release);
+        notFull_.fetch_add(1, std::memory_order_release);
+        FutexWake(notEmpty_, INT32_MAX);
+        FutexWake(notFull_, INT32_MAX);
+    }
+
+    void flush() { Notify(notEmpty_, consumerWaiters_); }
+
+    // 近似值: 并发修改时只作参考
+    size_t size() const {
+        size_t tail = enqueuePos_.load(std::memory_order_acquire);
+        size_t head = dequeuePos_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() >= capacity(); }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain word");
+
+    static void FutexWake(std::atomic<uint32_t>& word, int count) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr,
+                nullptr, 0);
+    }
+
+    // 有等待者时才推进序号并唤醒一个
+    static void Notify(std::atomic<uint32_t>& word, std::atomic<int>& waiters) {
+        //! 与 Wait 中的 "登记等待者 -> 再检查队列" 配对, 防止丢失唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            word.fetch_add(1, std::memory_order_release);
+            FutexWake(word, 1);
+        }
+    }
+
+    /**
+     * @brief 登记为等待者后再试一次, 仍失败才在 futex 上睡眠
+     * @return retry 成功返回 true; 被唤醒/超时返回 false, 由调用方重试
+     */
+    template <typename Retry>
+    static bool Wait(std::atomic<uint32_t>& word, uint32_t ticket, std::atomic<int>& waiters,
+                     Retry&& retry, long timeoutNs) {
+        // 先让出 CPU 重试几次: 对端通常很快就会放入/取走元素, 省去一次睡眠和唤醒
+        for (int i = 0; i < SPIN_; ++i) {
+            sched_yield();
+            if (retry()) return true;
+        }
+        waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (retry()) {
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        timespec ts{};
+        if (timeoutNs >= 0) {
+            ts.tv_sec = timeoutNs / 1000000000L;
+            ts.tv_nsec = timeoutNs % 1000000000L;
+        }
+        // 序号已变化时 futex 立即返回
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, ticket,
+                timeoutNs >= 0 ? &ts : nullptr, nullptr, 0);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    static constexpr int SPIN_{16};
+
+    Cell* cells_{nullptr};
+    size_t mask_{0};
+
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+
+    // 阻塞等待: futex 序号 + 等待者计数 (没有等待者时不唤醒)
+    alignas(64) std::atomic<uint32_t> notEmpty_{0};
+    std::atomic<int> consumerWaiters_{0};
+    alignas(64) std::atomic<uint32_t> notFull_{0};
+    std::atomic<int> producerWaiters_{0};
+    std::atomic<bool> shutdown_{false};
+};
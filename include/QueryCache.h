@@ -0,0 +1,334 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "EventLoop.h"
+
+/**
+ * @brief 读穿透查询结果缓存 (分片 + TTL + LRU + 请求合并)
+ * @details 用法 (leader 通过 r.leader 守卫结束本次查询):
+ *
+ *   auto r = co_await cache.Lookup(key);
+ *   if (!r.hit) {
+ *       V value = 查数据库...;
+ *       if (查询成功) r.leader.Fill(value);
+ *   }
+ *
+ * 守卫析构时若还没有 Fill 就自动 Abandon: 查询失败、抛出异常或协程帧被销毁时,
+ * 第一个等待者被唤醒并成为新的 leader (r.leader 非空), 其余继续等待, 不会永远挂起,
+ * 也不会在数据库变慢/出错时变成 N 个并发查询
+ *
+ * 同一个 key 并发未命中时只有第一个协程成为 leader 去查库,
+ * 其余协程挂起等待,leader Fill 后在各自的 EventLoop 上恢复并拿到同一结果
+ * @tparam V 缓存值类型,需可拷贝
+ */
+template <typename V>
+class QueryCache {
+public:
+    /**
+     * @brief leader 守卫: 未命中且由自己负责查询时非空, 析构时未 Fill 则 Abandon
+     */
+    class Leader {
+    public:
+        Leader() = default;
+        Leader(QueryCache* cache, std::string key) : cache_(cache), key_(std::move(key)) {}
+        ~Leader() { Abandon(); }
+
+        // 禁止拷贝,支持移动
+        Leader(const Leader&) = delete;
+        Leader& operator=(const Leader&) = delete;
+        Leader(Leader&& other) noexcept
+            : cache_(std::exchange(other.cache_, nullptr)), key_(std::move(other.key_)) {}
+        Leader& operator=(Leader&& other) noexcept {
+            if (this != &other) {
+                Abandon();
+                cache_ = std::exchange(other.cache_, nullptr);
+                key_ = std::move(other.key_);
+            }
+            return *this;
+        }
+
+        explicit operator bool() const { return cache_ != nullptr; }
+
+        // 查询成功: 写入缓存并唤醒等待者
+        void Fill(const V& value) {
+            if (cache_ != nullptr) std::exchange(cache_, nullptr)->Fill(key_, value);
+        }
+
+        // 查询失败: 把 leader 交给下一个等待者
+        void Abandon() {
+            if (cache_ != nullptr) std::exchange(cache_, nullptr)->Abandon(key_);
+        }
+
+    private:
+        QueryCache* cache_{nullptr};
+        std::string key_;
+    };
+
+    struct LookupResult {
+        bool hit{false};  // 命中 (或等到了 leader 的结果)
+        Leader leader;    // 未命中且由自己负责查询 (首次未命中, 或前一个 leader 放弃后接手)
+        V value{};
+    };
+
+    struct LookupAwaitable;
+
+    // capacity: 总容量, ttlMs: 过期时间, shardNum: 分片数 (每片一把锁)
+    explicit QueryCache(size_t capacity = 4096, int ttlMs = 30000, size_t shardNum = 16)
+        : ttlMs_(ttlMs), shards_(shardNum) {
+        if (capacity == 0 || shardNum == 0) {
+            throw std::runtime_error("QueryCache capacity and shardNum must > 0");
+        }
+        for (auto& shard : shards_) {
+            shard.capacity = (capacity + shardNum - 1) / shardNum;
+        }
+    }
+
+    // 禁止拷贝
+    QueryCache(const QueryCache&) = delete;
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    // co_await cache.Lookup(key)
+    LookupAwaitable Lookup(const std::string& key) { return LookupAwaitable{this, key}; }
+
+    //* 以下两个由 Leader 守卫调用
+    // leader 查询成功: 写入缓存并唤醒等待者
+    void Fill(const std::string& key, const V& value) {
+        Finish(key, [&](Entry& entry, Shard& shard) {
+            std::vector<Waiter> waiters = std::move(entry.waiters);
+            entry.waiters.clear();
+            if (entry.invalidated) {
+                // 查询期间被失效: 等待者拿这次的结果,但不写入缓存
+                shard.map.erase(key);
+            } else {
+                entry.ready = true;
+                entry.value = value;
+                entry.expireMs = NowMs() + ttlMs_;
+                shard.lru.push_front(key);
+                entry.lruIt = shard.lru.begin();
+                Evict(shard);
+            }
+            for (auto& waiter : waiters) {
+                waiter.out->hit = true;
+                waiter.out->value = value;
+            }
+            return waiters;
+        });
+    }
+
+    // leader 查询失败: 只唤醒第一个等待者接任 leader 重新查询, 其余继续等待; 没有等待者时删除占位
+    void Abandon(const std::string& key) {
+        Finish(key, [&](Entry& entry, Shard& shard) {
+            std::vector<Waiter> next;
+            if (entry.waiters.empty()) {
+                shard.map.erase(key);
+                return next;
+            }
+            next.push_back(entry.waiters.front());
+            entry.waiters.erase(entry.waiters.begin());
+            entry.invalidated = false;  // 新的查询在失效之后开始, 结果可以写入缓存
+            next.front().out->leader = Leader(this, key);
+            return next;
+        });
+    }
+
+    // 失效钩子: 数据被修改后调用; 正在查询中的 key 其结果不会写入缓存
+    void Invalidate(const std::string& key) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (auto it = shard.map.find(key); it != shard.map.end()) {
+            EraseOrMark(shard, it);
+        }
+    }
+
+    // 按条件失效
+    void InvalidateIf(const std::function<bool(const std::string&)>& pred) {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto it = shard.map.begin(); it != shard.map.end();) {
+                auto next = std::next(it);
+                if (pred(it->first)) EraseOrMark(shard, it);
+                it = next;
+            }
+        }
+    }
+
+    void Clear() {
+        InvalidateIf([](const std::string&) { return true; });
+    }
+
+    uint64_t getHitCount() const { return Sum(&Shard::hits); }
+    uint64_t getMissCount() const { return Sum(&Shard::misses); }
+    uint64_t getCoalescedCount() const { return Sum(&Shard::coalesced); }
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        EventLoop* loop;
+        LookupResult* out;  // 指向挂起协程帧中的等待体,恢复前一直有效
+    };
+
+    struct Entry {
+        bool ready{false};        // false 表示 leader 正在查询
+        bool invalidated{false};  // 查询期间被失效
+        V value{};
+        int64_t expireMs{0};
+        std::list<std::string>::iterator lruIt{};
+        std::vector<Waiter> waiters;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> map;
+        std::list<std::string> lru;  // 只包含 ready 的条目,队头最近使用
+        size_t capacity{0};
+        std::atomic<uint64_t> hits{0}, misses{0}, coalesced{0};
+    };
+
+    static int64_t NowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    Shard& ShardOf(const std::string& key) {
+        return shards_[std::hash<std::string>{}(key) % shards_.size()];
+    }
+
+    uint64_t Sum(std::atomic<uint64_t> Shard::*field) const {
+        uint64_t total = 0;
+        for (auto& shard : shards_) total += (shard.*field).load(std::memory_order_relaxed);
+        return total;
+    }
+
+    /**
+     * @brief 查询入口 (Lookup 等待体使用)
+     * @return true 结果已确定 (命中/成为 leader/无法等待); false 需要挂起,
+     * hd 非空时已登记为等待者
+     */
+    bool Begin(const std::string& key, LookupResult& out, std::coroutine_handle<> hd) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end() && it->second.ready && it->second.expireMs <= NowMs()) {
+            shard.lru.erase(it->second.lruIt);  // 过期,按未命中处理
+            shard.map.erase(it);
+            it = shard.map.end();
+        }
+        if (it == shard.map.end()) {
+            shard.map.emplace(key, Entry{});  // 占位,后来者合并到这次查询
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            out.leader = Leader(this, key);
+            return true;
+        }
+        Entry& entry = it->second;
+        if (entry.ready) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruIt);
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            out.hit = true;
+            out.value = entry.value;
+            return true;
+        }
+        // 已有 leader 在查询
+        if (t_loop == nullptr || t_loop->IsStopped()) {
+            return true;  // 不在 EventLoop 线程 (或 Loop 已停止) 无法挂起,自己去查 (不 Fill)
+        }
+        if (!hd) {
+            return false;
+        }
+        shard.coalesced.fetch_add(1, std::memory_order_relaxed);
+        entry.waiters.push_back({hd, t_loop, &out});
+        return false;
+    }
+
+    // Loop 停止: 把等待者摘下, 返回 false 表示 leader 已经结束, 恢复任务已投递
+    bool CancelWait(const std::string& key, const LookupResult* out) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        return std::erase_if(it->second.waiters,
+                             [out](const Waiter& waiter) { return waiter.out == out; }) > 0;
+    }
+
+    // 结束一次查询: fn 在锁内处理条目并返回要唤醒的等待者
+    template <typename Fn>
+    void Finish(const std::string& key, Fn&& fn) {
+        std::vector<Waiter> waiters;
+        {
+            Shard& shard = ShardOf(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it == shard.map.end() || it->second.ready) {
+                return;  // 没有进行中的查询
+            }
+            waiters = fn(it->second, shard);
+        }
+        // 在等待者各自的 EventLoop 上恢复
+        for (auto& waiter : waiters) {
+            waiter.loop->RunInLoop([hd = waiter.handle]() { hd.resume(); });
+        }
+    }
+
+    void EraseOrMark(Shard& shard, typename std::unordered_map<std::string, Entry>::iterator it) {
+        if (it->second.ready) {
+            shard.lru.erase(it->second.lruIt);
+            shard.map.erase(it);
+        } else {
+            it->second.invalidated = true;
+        }
+    }
+
+    // 超出容量时淘汰最久未使用的条目
+    void Evict(Shard& shard) {
+        while (shard.lru.size() > shard.capacity) {
+            shard.map.erase(shard.lru.back());
+            shard.lru.pop_back();
+        }
+    }
+
+    int ttlMs_;
+    std::vector<Shard> shards_;
+};
+
+/**
+ * @brief 等待体: auto r = co_await cache.Lookup(key);
+ */
+template <typename V>
+struct QueryCache<V>::LookupAwaitable {
+    QueryCache* cache;
+    std::string key;
+    LookupResult result{};
+    CancellationRegistration stopReg;  // Loop 停止时摘除等待
+
+    bool await_ready() { return cache->Begin(key, result, nullptr); }
+
+    // 登记时 leader 可能刚好完成,此时不挂起
+    bool await_suspend(std::coroutine_handle<> hd) {
+        if (cache->Begin(key, result, hd)) {
+            return false;
+        }
+        // Loop 停止时按未命中恢复 (hit = leader = false), 与 leader 结束在分片锁内决出先后
+        stopReg = t_loop->getStopToken().OnCancel([this, hd]() {
+            if (cache->CancelWait(key, &result)) hd.resume();
+        });
+        return true;
+    }
+
+    LookupResult await_resume() {
+        stopReg.Reset();
+        return std::move(result);
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "EventLoop.h"
+
+/**
+ * @brief "在别的线程执行 fn, 回到原 Loop 恢复协程" 的等待体公共部分 (Compute / Offload 共用)
+ * @details 保存 fn 的结果或异常; 挂起时记下原 Loop 和协程句柄, 执行完由 ResumeHome 恢复.
+ * 派生类只需决定把自己交给谁执行 (工作窃取队列 / 阻塞任务线程池)
+ */
+template <typename F>
+struct RemoteCall {
+    using R = std::invoke_result_t<F&>;
+    using Value = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+    F fn;
+    EventLoop* home{nullptr};
+    std::coroutine_handle<> handle;
+    std::optional<Value> value;
+    std::exception_ptr error;
+    bool done{false};
+
+    explicit RemoteCall(F&& f) : fn(std::move(f)) {}
+
+    // 执行 fn, 记录结果或异常
+    void Invoke() {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                fn();
+                value.emplace();
+            } else {
+                value.emplace(fn());
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done = true;
+    }
+
+    // 挂起: 记下原 Loop 和协程
+    void Park(std::coroutine_handle<> hd) {
+        home = t_loop;
+        handle = hd;
+    }
+
+    /**
+     * @brief 在原 Loop 恢复协程: current 就是原 Loop 时直接恢复, 否则投递回去
+     * @note 调用后不能再访问 this: 协程恢复后会销毁这个等待体
+     */
+    void ResumeHome(EventLoop* current) {
+        auto hd = handle;
+        if (current == home) {
+            hd.resume();
+            return;
+        }
+        home->RunInLoop([hd]() { hd.resume(); });
+    }
+
+    // await_resume: 没有挂起 (不在 Loop 线程等) 时就地执行; 重新抛出 fn 的异常
+    R Result() {
+        if (!done) Invoke();
+        if (error) std::rethrow_exception(error);
+        if constexpr (!std::is_void_v<R>) {
+            return std::move(*value);
+        }
+    }
+};
@@ -1,112 +1,164 @@
 #pragma once
+#include <cassert>
 #include <coroutine>
 #include <exception>
+#include <optional>
+#include <utility>
+
+#include "FrameAllocator.h"
+#include "Log.h"
+
+template <typename T>
+class Task;
+
+namespace detail {
 
 /**
- * @brief Task: 协程函数的返回类型
- *  C++20 协程任何使用 co_await/co_return 的函数,其返回类型必须包含名为 promise_type的嵌套类型
+ * @brief 协程结束时的等待体
+ * 1. 有等待方 (被 co_await): 对称转移 (symmetric transfer) 到等待方, 不增加调用栈深度
+ * 2. 已 Detach: 没有人持有 Task, 由协程自己销毁帧
+ * 3. 否则挂起, 由 Task 析构时销毁帧
  */
-template <typename T = void>
-struct Task {
-    // 1. 嵌套的promise_type(C++20强制要求的名称)
-    struct promise_type {
-        T value;                           // 存储协程返回值
-        std::exception_ptr exception_ptr;  // 存储异常
-
-        // 作用：协程创建时，返回一个Task对象给调用者(外部操作协程的句柄)
-        Task get_return_object() {
-            // from_promise：从promise对象创建对应的coroutine_handle
-            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> hd) noexcept {
+        auto& promise = hd.promise();
+        if (promise.continuation) {
+            return promise.continuation;
         }
+        if (promise.detached) {
+            if (promise.exception_ptr) {
+                try {
+                    std::rethrow_exception(promise.exception_ptr);
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Detached task exited with exception: {}", e.what());
+                } catch (...) {
+                    LOG_ERROR("Detached task exited with unknown exception");
+                }
+            }
+            hd.destroy();
+        }
+        return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+};
+
+// Task<T> 与 Task<void> 共用的 promise 部分
+struct PromiseBase {
+    std::coroutine_handle<> continuation;  // co_await 本任务的协程, 结束时恢复它
+    std::exception_ptr exception_ptr;      // 存储异常, 在等待方 co_await 处重新抛出
+    bool detached{false};                  // 已 Detach, 结束时自行销毁
 
-        // 协程初始化行为 std::suspend_never 立即执行,不挂起
-        std::suspend_never initial_suspend() { return {}; }
+    // 协程帧从线程内的分级空闲链表分配, 不走全局 operator new
+    static void* operator new(size_t size) { return FrameAllocator::Allocate(size); }
+    static void operator delete(void* ptr) noexcept { FrameAllocator::Deallocate(ptr); }
 
-        // 协程结束时行为 std::suspend_always 结束后挂起,确保Task可以读取返回值
-        std::suspend_always final_suspend() noexcept { return {}; }
+    // 惰性启动: 创建后先挂起, 被 co_await 或 Detach 时才开始执行
+    std::suspend_always initial_suspend() noexcept { return {}; }
 
-        // 处理 co_return
-        void return_value(T v) { value = v; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
 
-        // 处理未捕获异常
-        void unhandled_exception() { exception_ptr = std::current_exception(); }
-    };
+    // 处理未捕获异常
+    void unhandled_exception() { exception_ptr = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : PromiseBase {
+    std::optional<T> value;  // 存储协程返回值
+
+    Task<T> get_return_object();
+
+    // 处理 co_return
+    template <typename U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+};
+
+template <>
+struct TaskPromise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+}  // namespace detail
+
+/**
+ * @brief Task: 协程函数的返回类型
+ *  C++20 协程任何使用 co_await/co_return 的函数,其返回类型必须包含名为 promise_type的嵌套类型
+ * @details
+ * - 惰性启动: 调用协程函数只创建帧, 不执行
+ * - 可等待: co_await task 启动子协程, 子协程结束后对称转移回等待方, 深层调用链也不会爆栈
+ * - 拥有帧: Task 析构时销毁协程帧; 顶层协程 (没有等待方) 用 Detach() 启动, 结束后自行销毁
+ */
+template <typename T = void>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
 
-    // 2. 协程句柄(外部操作协程的核心: 恢复、销毁、获取promise)
-    std::coroutine_handle<promise_type> handle;
-    // 构造函数
-    explicit Task(std::coroutine_handle<promise_type> hd) : handle(hd) {}
+    explicit Task(std::coroutine_handle<promise_type> hd) : handle_(hd) {}
 
     // 禁用拷贝,支持移动(避免析构重复销毁)
     Task(const Task&) = delete;
     Task& operator=(const Task&) = delete;
-    Task(Task&& other) noexcept {
-        // 转移所有权
-        handle = other.handle;
-        other.handle = nullptr;
-    }
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
     Task& operator=(Task&& other) noexcept {
-        if (this != other) {
-            if (handle) handle.destroy();
-            handle = other.handle;
-            other.handle = nullptr;
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
         }
         return *this;
     }
-    // 析构函数：释放协程句柄
+
+    //! 析构时销毁协程帧: 协程必须已结束或从未启动 (挂起在 IO 上的帧由等待方持有, 不会提前析构)
     ~Task() {
-        //! Task析构不销毁句柄,不然会段错误
-        // if (handle) handle.destroy();
+        if (handle_) handle_.destroy();
     }
 
-    // 获取返回值
-    T get_result() {
-        // 如果协程内有未处理异常，重新抛出(让外部捕获)
-        if (handle.promise().exception_ptr) {
-            std::rethrow_exception(handle.promise().exception_ptr);
-        }
-        return handle.promise().value;
+    /**
+     * @brief 启动顶层协程并放弃所有权, 协程结束时自行销毁帧
+     */
+    void Detach() {
+        auto hd = std::exchange(handle_, nullptr);
+        hd.promise().detached = true;
+        hd.resume();
     }
-};
 
-/**
- * @brief void特化版本
- */
-template <>
-struct Task<void> {
-    struct promise_type {
-        std::exception_ptr exception_ptr;
-        Task get_return_object() {
-            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
-        }
-        std::suspend_never initial_suspend() { return {}; }
-        std::suspend_never final_suspend() noexcept { return {}; }
-        void return_void() {}
-        void unhandled_exception() { exception_ptr = std::current_exception(); }
-    };
-    std::coroutine_handle<promise_type> handle;
-    explicit Task(std::coroutine_handle<promise_type> hd) : handle(hd) {}
-    // 同样禁用拷贝,支持移动
-    Task(const Task&&) = delete;
-    Task& operator=(const Task&) = delete;
-    Task(Task&& other) {
-        handle = other.handle;
-        other.handle = nullptr;
+    //* 等待体接口: co_await task
+    //! 只能 co_await 持有协程的 Task: 已 Detach 或被移走的 Task 没有结果可取
+    bool await_ready() const noexcept {
+        assert(handle_ && "co_await on an empty Task");
+        return handle_.done();
     }
-    Task& operator=(Task&& other) {
-        if (this != &other) {
-            handle = other.handle;
-            other.handle = nullptr;
-        }
-        return *this;
-    }
-    ~Task() {
-        //! Task析构不销毁句柄,不然会段错误
-        // if (handle) handle.destroy();
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;  // 对称转移: 直接切换到子协程
     }
-    void get_result() {
-        if (handle.promise().exception_ptr) {
-            std::rethrow_exception(handle.promise().exception_ptr);
+
+    T await_resume() {
+        // 如果协程内有未处理异常，重新抛出(让等待方捕获)
+        if (handle_.promise().exception_ptr) {
+            std::rethrow_exception(handle_.promise().exception_ptr);
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*handle_.promise().value);
         }
     }
-};
\ No newline at end of file
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> detail::TaskPromise<T>::get_return_object() {
+    // from_promise：从promise对象创建对应的coroutine_handle
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object() {
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
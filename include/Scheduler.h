@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "EventLoop.h"
+#include "RemoteCall.h"
+
+/**
+ * @brief 跨 Worker 的工作窃取调度
+ * @details 每个 Worker 的 EventLoop 有一个 Chase-Lev 运行队列. 协程通过 co_await Compute(fn)
+ * 把 CPU 密集的计算投递到本 Loop 的队列, 空闲的 Worker 会从顶部窃取执行.
+ * 不论计算在哪个线程执行, 协程总是回到原 Loop 恢复, fd 的 epoll 注册和定时器仍归原 Loop 所有.
+ * 参与窃取的 Loop 在启动时一次性登记, 之后只读: 窃取和唤醒都不加锁
+ */
+class Scheduler {
+public:
+    /**
+     * @brief 登记所有 Worker 的 Loop (创建完 Worker 后调用一次, 之前不会发生窃取)
+     * @note Loop 必须在 Reset 之前一直有效: 先停止并 join 所有 Worker, 再 Reset, 最后析构 Loop
+     */
+    static void SetLoops(std::vector<EventLoop*> loops);
+    static void Reset();
+
+    // 空闲的 thief 从其他 Loop 窃取一个任务
+    static bool Steal(EventLoop* thief, StealableJob*& job);
+
+    // 任务计数: 投递时 +1 并轮流唤醒一个睡眠中的 Worker, 被取走 (Pop/Steal) 时 -1
+    static void JobPosted(EventLoop* owner);
+    static void JobTaken() { pending_.fetch_sub(1, std::memory_order_relaxed); }
+    static bool HasPending() { return pending_.load(std::memory_order_relaxed) > 0; }
+
+    // 累计被窃取执行的任务数
+    static uint64_t getStolenCount() { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    static inline std::vector<EventLoop*> loops_;
+    static inline std::atomic<size_t> loopNum_{0};  // 发布 loops_: 读取方先 acquire 读它
+    static inline std::atomic<int64_t> pending_{0};
+    static inline std::atomic<uint64_t> stolen_{0};
+    static inline std::atomic<size_t> wakeCursor_{0};  // 下次从哪个 Loop 开始找睡眠的 Worker
+};
+
+/**
+ * @brief 把计算 fn 交给工作窃取调度: 可能在其他 Worker 上执行, 完成后在原 Loop 恢复协程
+ * 用法: auto digest = co_await Compute([&] { return Sha256(body); });
+ * fn 的异常会在 co_await 处重新抛出. 不在 Loop 线程时直接在当前线程执行
+ * @note fn 在其他线程执行时, 不能访问只属于原 Loop 的资源 (t_loop、BufferPool、Socket IO)
+ */
+template <typename F>
+auto Compute(F fn) {
+    struct ComputeAwaitable : StealableJob, RemoteCall<F> {
+        explicit ComputeAwaitable(F&& f) : RemoteCall<F>(std::move(f)) { run = &Run; }
+
+        static void Run(StealableJob* job, EventLoop* runner) {
+            auto* self = static_cast<ComputeAwaitable*>(job);
+            self->Invoke();
+            //! 本 Loop 执行时直接恢复, 被窃取时投递回原 Loop; 之后不能再访问 self
+            self->ResumeHome(runner);
+        }
+
+        bool await_ready() { return t_loop == nullptr; }
+
+        void await_suspend(std::coroutine_handle<> hd) {
+            this->Park(hd);
+            this->home->PostJob(this);
+        }
+
+        auto await_resume() { return this->Result(); }  // 不在 Loop 线程时未挂起, 就地执行
+    };
+    return ComputeAwaitable{std::move(fn)};
+}
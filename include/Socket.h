@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Buffer.h"
+#include "ChainBuffer.h"
 #include "IoAwaitable.h"
 #include "Log.h"
 
@@ -69,8 +70,8 @@ public:
     // 获取原始fd(仅用于 epoll注册)
     int getFd() const { return fd_; }
 
-    // Accept 返回一个Socket对象,具备RAII特性
-    Socket Accept();
+    // Accept 返回一个Socket对象,具备RAII特性; peer 非空时写入对端地址
+    Socket Accept(sockaddr_in* peer = nullptr);
 
     void Connect(const std::string& ip, const uint16_t port);
 
@@ -80,79 +81,171 @@ public:
     void SetNonBlocking();  // 设置非阻塞
     void SetReuseAddr();    // 设置地址复用
 
-    auto Read(Buffer& buffer) {
+    /**
+     * @brief 等待可读并读到 EAGAIN 为止
+     * 返回读到的字节数; 0 表示对端关闭; -1 表示出错, 超时/取消时 errno 为 ETIMEDOUT/ECANCELED
+     */
+    auto Read(Buffer& buffer, IoOptions opts = {}) {
         // 定义内部结构体来实现 Read 的 Awaitable
         struct ReadAwaitable {
             int fd;
             Buffer& buf;
+            IoOptions opts;
+            int err{0};
 
             bool await_ready() { return false; }  // 总是挂起
 
-            void await_suspend(std::coroutine_handle<> hd) {
+            bool await_suspend(std::coroutine_handle<> hd) {
                 //* 注册 EPOLLIN | EPOLLET
-                if (t_loop) {
-                    t_loop->WaitFor(fd, hd);
-                    try {
-                        t_loop->GetEpoll().Mod(fd, EPOLLIN | EPOLLET);
-                    } catch (...) {
-                        t_loop->GetEpoll().Add(fd, EPOLLIN | EPOLLET);
-                    }
+                if (t_loop == nullptr || !t_loop->WaitFor(fd, hd, &err, opts)) {
+                    return false;  // 已超时/已取消,不挂起
+                }
+                try {
+                    t_loop->GetEpoll().Mod(fd, EPOLLIN | EPOLLET);
+                } catch (...) {
+                    t_loop->GetEpoll().Add(fd, EPOLLIN | EPOLLET);
                 }
+                return true;
             }
 
             ssize_t await_resume() {
-                // 彻底抽干内核缓冲区,防止频繁挂起,恢复
-                // 使用 Buffer::ReadFd 进行分散读
-                ssize_t total_read = 0;
-                while (true) {
-                    int savedErrno = 0;
-                    ssize_t n = buf.ReadFd(fd, &savedErrno);
-                    if (n > 0) {
-                        total_read += n;
-                    } else if (n == -1 && savedErrno == EAGAIN) {
-                        break;  // 抽干了
-                    } else {
-                        if (total_read == 0) return n;  // 真正的错误或EOF
-                        break;
-                    }
+                if (err != 0) {
+                    errno = err;
+                    return -1;
                 }
-                return total_read;
+                return ReadAll(fd, buf);
             }
         };
-        return ReadAwaitable{fd_, buffer};
+        return ReadAwaitable{fd_, buffer, std::move(opts)};
+    }
+
+    // 只等待可读, 不读数据 (空闲连接等待期间不持有读缓冲区); 返回 0 或 ETIMEDOUT/ECANCELED
+    IoAwaitable WaitReadable(IoOptions opts = {}) { return IoAwaitable{fd_, EPOLLIN, std::move(opts)}; }
+
+    /**
+     * @brief 非阻塞地读到 EAGAIN 为止, 彻底抽干内核缓冲区, 防止频繁挂起/恢复
+     * 返回读到的总字节数; 0 表示对端关闭, -1 表示出错
+     */
+    static ssize_t ReadAll(int fd, Buffer& buf) {
+        // 使用 Buffer::ReadFd 进行分散读
+        ssize_t total_read = 0;
+        while (true) {
+            int savedErrno = 0;
+            ssize_t n = buf.ReadFd(fd, &savedErrno);
+            if (n > 0) {
+                total_read += n;
+            } else if (n == -1 && savedErrno == EAGAIN) {
+                break;  // 抽干了
+            } else {
+                if (total_read == 0) return n;  // 真正的错误或EOF
+                break;
+            }
+        }
+        return total_read;
     }
+    ssize_t ReadAll(Buffer& buf) { return ReadAll(fd_, buf); }
 
-    auto Write(const void* data, size_t len) {
+    auto Write(const void* data, size_t len, IoOptions opts = {}) {
         struct WriteAwaitable {
             int fd;
             const void* data;
             size_t len;
+            IoOptions opts;
+            int err{0};
 
             bool await_ready() { return false; }  // 总是挂起
 
-            void await_suspend(std::coroutine_handle<> hd) {
+            bool await_suspend(std::coroutine_handle<> hd) {
                 //* 注册 EPOLLOUT(可写) | EPOLLET
-                if (t_loop != nullptr) {
-                    t_loop->WaitFor(fd, hd);
-                    try {
-                        t_loop->GetEpoll().Mod(fd, EPOLLOUT | EPOLLET);
-                    } catch (...) {
-                        t_loop->GetEpoll().Add(fd, EPOLLOUT | EPOLLET);
-                    }
+                if (t_loop == nullptr || !t_loop->WaitFor(fd, hd, &err, opts)) {
+                    return false;
                 }
+                try {
+                    t_loop->GetEpoll().Mod(fd, EPOLLOUT | EPOLLET);
+                } catch (...) {
+                    t_loop->GetEpoll().Add(fd, EPOLLOUT | EPOLLET);
+                }
+                return true;
             }
 
             ssize_t await_resume() {
+                if (err != 0) {
+                    errno = err;
+                    return -1;
+                }
                 ssize_t n = ::send(fd, data, len, 0);
                 return n;
             }
         };
-        return WriteAwaitable{fd_, data, len};
+        return WriteAwaitable{fd_, data, len, std::move(opts)};
     }
 
     // 重载版本：支持 Buffer
     auto Write(Buffer& buffer) { return Write(buffer.Peek(), buffer.ReadableBytes()); }
 
+    /**
+     * @brief 聚集写: 把 ChainBuffer 的各段用 writev 一次发出, 写出的部分自动从 buffer 取走
+     * 先直接尝试写, 只有内核发送缓冲区满 (EAGAIN) 时才挂起等待 EPOLLOUT.
+     * 返回本次写出的字节数 (buffer 未写完时调用方需再次 co_await), -1 表示出错 (errno 有效,
+     * 等待可写超时/被取消时为 ETIMEDOUT/ECANCELED)
+     */
+    auto Writev(ChainBuffer& buffer, IoOptions opts = {}) {
+        struct WritevAwaitable {
+            int fd;
+            ChainBuffer& buf;
+            IoOptions opts;
+            ssize_t written{0};
+            int err{0};
+            int waitErr{0};  // 等待可写时的超时/取消
+            bool suspended{false};
+
+            // 写到 buffer 为空、EAGAIN 或出错为止; 返回 false 表示需要等待可写
+            bool TryWrite() {
+                while (buf.ReadableBytes() > 0) {
+                    ssize_t n = buf.WriteFd(fd, &err);
+                    if (n > 0) {
+                        written += n;
+                        continue;
+                    }
+                    if (n < 0 && err == EINTR) continue;
+                    if (n < 0 && err == EAGAIN) return written > 0;
+                    return true;  // 出错, 交给 await_resume 处理
+                }
+                return true;
+            }
+
+            bool await_ready() { return TryWrite() || t_loop == nullptr; }
+
+            bool await_suspend(std::coroutine_handle<> hd) {
+                if (!t_loop->WaitFor(fd, hd, &waitErr, opts)) {
+                    return false;
+                }
+                suspended = true;
+                try {
+                    t_loop->GetEpoll().Mod(fd, EPOLLOUT | EPOLLET);
+                } catch (...) {
+                    t_loop->GetEpoll().Add(fd, EPOLLOUT | EPOLLET);
+                }
+                return true;
+            }
+
+            ssize_t await_resume() {
+                if (waitErr != 0) {
+                    err = waitErr;
+                } else if (suspended) {
+                    err = 0;
+                    TryWrite();  // 被 EPOLLOUT 唤醒
+                }
+                if (written > 0) return written;
+                if (buf.ReadableBytes() == 0) return 0;
+                if (err == 0) err = EAGAIN;
+                errno = err;
+                return -1;
+            }
+        };
+        return WritevAwaitable{fd_, buffer, std::move(opts)};
+    }
+
 private:
     int fd_;
 };
\ No newline at end of file
@@ -1,72 +1,337 @@
 #pragma once
+#include <mysql/errmsg.h>
 #include <mysql/mysql.h>
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <semaphore>  //C++20
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "EventLoop.h"
 #include "Log.h"
+#include "SqlStmt.h"
 
 class SqlConnPool {
 public:
+    // 等待时间直方图: 第 i 个桶统计等待时间 < 2^i 微秒的次数, 最后一个桶统计更长的
+    static const int kWaitBuckets{24};
+
+    struct AcquireAwaitable;
+
     static SqlConnPool* getInstance() {
         static SqlConnPool connPool;
         return &connPool;
     }
 
     // 初始化连接池
+    // shardNum > 0 时开启分片模式: 连接平均分给 shardNum 个分片,
+    // 每个 Worker (按 EventLoop id) 优先使用自己的分片,取空时从兄弟分片窃取
     void Init(const char* host, int port, const char* user, const char* pwd, const char* dbName,
-              int connSize = 10);
+              int connSize = 10, int shardNum = 0);
 
-    // 获取连接
+    // 启动后台维护线程 (在 Init 之后调用):
+    // 1. 每 checkIntervalMs 对空闲超过该时长的连接 mysql_ping,失败则重连
+    // 2. 有协程排队且连接数 < maxConn 时扩容; 连接数 < minConn 时补齐
+    // 3. 空闲超过 idleTimeoutMs 的连接在连接数 > minConn 时关闭
+    void StartHealthCheck(int minConn, int maxConn, int checkIntervalMs = 5000,
+                          int idleTimeoutMs = 60000);
+
+    // 获取连接 (阻塞当前线程,仅用于非 EventLoop 线程)
     MYSQL* GetConn();
 
-    // 释放连接
+    // 协程获取连接: co_await pool->Acquire(timeoutMs)
+    // 连接全忙时协程在 FIFO 队列中挂起,不阻塞线程; timeoutMs < 0 表示不限时
+    // 超时返回空的 SqlConn
+    AcquireAwaitable Acquire(int timeoutMs = -1);
+
+    // 释放连接: 有等待者时直接移交给队首等待者
     void FreeConn(MYSQL* conn);
 
-    // 关闭连接池
+    // 关闭连接池, 重复调用无操作
     void ClosePool();
 
+    // 获取连接对应的预处理语句缓存 (首次调用时创建)
+    SqlStmtCache* GetStmtCache(MYSQL* sql);
+
     // 获取空闲连接数
-    int getFreeConnCount() { return freeCount_; }
+    int getFreeConnCount();
+
+    // 获取当前存活的连接总数 (空闲 + 使用中)
+    int getConnCount() const { return connNum_.load(std::memory_order_relaxed); }
+
+    // 获取重连次数
+    uint64_t getReconnectCount() const { return reconnects_.load(std::memory_order_relaxed); }
+
+    // 获取当前排队等待连接的数量
+    int getWaiterCount() const { return waiterNum_.load(std::memory_order_relaxed); }
+
+    // 获取从兄弟分片窃取连接的次数
+    uint64_t getStealCount() const { return steals_.load(std::memory_order_relaxed); }
+
+    // 获取等待时间直方图快照
+    std::vector<uint64_t> getWaitHistogram() const;
+
+    // 获取等待超时次数
+    uint64_t getWaitTimeoutCount() const { return waitTimeouts_.load(std::memory_order_relaxed); }
 
 private:
-    SqlConnPool() : useCount_{0}, freeCount_{0} {}
+    /**
+     * @brief 等待连接的协程或线程
+     * 协程等待者: handle + loop, 由 FreeConn 通过 RunInLoop 在原 EventLoop 上恢复
+     * 线程等待者: sem, 由 FreeConn 直接 release
+     */
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        EventLoop* loop{nullptr};
+        std::unique_ptr<std::binary_semaphore> sem{nullptr};
+        MYSQL* conn{nullptr};  // 移交的连接
+        int timerId{0};        // 0 表示不限时
+    };
+
+    // 空闲槽位: since 为连接开始空闲的时刻 (毫秒), 用于挑选需要 ping/回收的连接
+    struct Slot {
+        std::atomic<MYSQL*> conn{nullptr};
+        std::atomic<int64_t> since{0};
+    };
+
+    // 中心队列中的空闲连接
+    struct IdleConn {
+        MYSQL* sql;
+        int64_t since;
+    };
+
+    /**
+     * @brief 连接分片: 槽位是原子指针, nullptr 表示空槽
+     * 取连接 exchange(nullptr), 还连接 CAS(nullptr -> conn), 快速路径不加锁
+     * 按缓存行对齐,避免不同 Worker 的分片伪共享
+     */
+    struct alignas(64) Shard {
+        explicit Shard(int capacity) : slots(capacity) {}
+        std::vector<Slot> slots;
+    };
+
+    SqlConnPool() {}
     ~SqlConnPool() { ClosePool(); }
 
-    int MAX_CONN_;
-    int useCount_;
-    int freeCount_;
+    // 尝试立即取出空闲连接,没有则返回 nullptr
+    MYSQL* TryGetConn();
+
+    // 当前线程对应的分片下标
+    int ShardIndex() const;
+
+    // 从本线程分片取连接,取空则依次窃取兄弟分片
+    MYSQL* TakeFromShards();
+
+    // 放回本线程分片,分片满时尝试兄弟分片,全满返回 false
+    bool PutToShards(MYSQL* sql, int64_t since);
+
+    // 取/放空闲连接 (分片 + 中心队列), 需持有 mutex_
+    // 中心队列按 LIFO 复用,冷连接沉在队头,便于按空闲时长回收
+    MYSQL* TakeIdle();
+    void PutIdle(MYSQL* sql, int64_t since);
+
+    // 新建一条连接,失败返回 nullptr
+    MYSQL* Connect();
+
+    // 关闭连接并释放它的语句缓存
+    void CloseConn(MYSQL* sql);
+
+    // 把空闲连接交给等待者或放回空闲集合, since 为其空闲起始时刻
+    void Release(MYSQL* sql, int64_t since);
+
+    // 后台维护线程
+    void HealthCheckLoop();
+
+    // 取出一条空闲超过 minIdleMs 且不在 checked 中的连接, 没有时返回 false
+    bool TakeStale(int64_t minIdleMs, const std::unordered_set<MYSQL*>& checked, IdleConn& out);
+
+    // 关闭断线的连接并重新建立 (阻塞调用, 不能在 Loop 线程执行)
+    struct ReconnectJob;
+    void Reconnect(MYSQL* sql);
+
+    static int64_t NowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    // 协程挂起前登记等待者,如果此时恰好有空闲连接则直接取走并返回 false
+    bool Park(const std::shared_ptr<Waiter>& waiter);
+
+    // 超时: 把等待者从队列中摘除,返回 false 表示它已经拿到连接
+    bool CancelWait(const std::shared_ptr<Waiter>& waiter);
+
+    // 唤醒拿到连接的等待者
+    static void Wake(const std::shared_ptr<Waiter>& waiter);
+
+    void RecordWait(std::chrono::nanoseconds wait, bool timeout);
+
+    int MAX_CONN_{0};
+    int minConn_{0};
+    int checkIntervalMs_{5000};
+    int idleTimeoutMs_{60000};
 
-    std::queue<MYSQL*> connQue_;
+    // 连接参数,重连/扩容时使用
+    std::string host_, user_, pwd_, dbName_;
+    int port_{0};
+
+    std::atomic<int> connNum_{0};  // 存活连接数
+    std::atomic<bool> closed_{false};  // ClosePool 只执行一次 (main 和析构都会调用)
+    std::atomic<uint64_t> reconnects_{0};
+
+    std::deque<IdleConn> connQue_;
+    std::deque<std::shared_ptr<Waiter>> waiters_;  // FIFO 等待队列
     std::mutex mutex_;
-    std::unique_ptr<std::counting_semaphore<1000>> sem_;
+
+    std::vector<std::unique_ptr<Shard>> shards_;  // 为空表示未开启分片模式
+    std::atomic<int> waiterNum_{0};               // waiters_.size() 的无锁镜像
+    std::atomic<uint64_t> steals_{0};
+
+    // 每个连接一份预处理语句缓存,连接集合很少变化,读多写少
+    std::unordered_map<MYSQL*, std::unique_ptr<SqlStmtCache>> stmtCaches_;
+    std::shared_mutex stmtMutex_;
+
+    // 后台维护线程
+    std::unique_ptr<std::thread> healthThread_{nullptr};
+    std::mutex healthMutex_;
+    std::condition_variable healthCv_;
+    bool healthStop_{false};
+    bool growRequested_{false};
+    std::vector<MYSQL*> broken_;  // FreeConn 发现断线的连接,交给维护线程重连
+
+    std::array<std::atomic<uint64_t>, kWaitBuckets> waitBuckets_{};
+    std::atomic<uint64_t> waitTimeouts_{0};
 };
 
+/**
+ * @brief RAII 连接守卫: 析构时归还连接
+ */
 class SqlConn {
 public:
-    SqlConn(MYSQL** sql, SqlConnPool* connpool) {
+    SqlConn(MYSQL** sql, SqlConnPool* connpool) : sql_(nullptr), connpool_(connpool) {
         if (connpool == nullptr) {
-            LOG_ERROR("connpool nullptr: {}", std::string(strerror(errno)));
+            LOG_ERROR("connpool nullptr");
+            *sql = nullptr;
+            return;
         }
         *sql = connpool->GetConn();
         sql_ = *sql;
-        connpool_ = connpool;
     }
 
+    // 接管已取出的连接
+    SqlConn(MYSQL* sql, SqlConnPool* connpool) : sql_(sql), connpool_(connpool) {}
+
     ~SqlConn() {
         if (sql_ != nullptr) {
             connpool_->FreeConn(sql_);
         }
     }
 
+    // 禁止拷贝,支持移动
+    SqlConn(const SqlConn&) = delete;
+    SqlConn& operator=(const SqlConn&) = delete;
+    SqlConn(SqlConn&& other) noexcept : sql_(other.sql_), connpool_(other.connpool_) {
+        other.sql_ = nullptr;
+    }
+    SqlConn& operator=(SqlConn&& other) noexcept {
+        if (this != &other) {
+            if (sql_ != nullptr) connpool_->FreeConn(sql_);
+            sql_ = other.sql_;
+            connpool_ = other.connpool_;
+            other.sql_ = nullptr;
+        }
+        return *this;
+    }
+
+    MYSQL* get() const { return sql_; }
+
+    // 获取本连接上 query 对应的预处理语句 (已缓存则直接复用)
+    SqlStmt* Stmt(const std::string& query) {
+        if (sql_ == nullptr) return nullptr;
+        return connpool_->GetStmtCache(sql_)->Get(query);
+    }
+
+    // 连接池繁忙或获取超时时为 false
+    explicit operator bool() const { return sql_ != nullptr; }
+
 private:
     MYSQL* sql_;
     SqlConnPool* connpool_;
-};
\ No newline at end of file
+};
+
+/**
+ * @brief 等待体: SqlConn conn = co_await pool->Acquire(timeoutMs);
+ */
+struct SqlConnPool::AcquireAwaitable {
+    SqlConnPool* pool;
+    int timeoutMs;
+    MYSQL* sql{nullptr};
+    std::shared_ptr<Waiter> waiter{nullptr};
+    TimeStamp start{};
+    CancellationRegistration stopReg;  // Loop 停止时摘除等待
+
+    bool await_ready() {
+        start = Clock::now();
+        sql = pool->TryGetConn();
+        if (sql == nullptr && t_loop == nullptr) {
+            sql = pool->GetConn();  // 不在 EventLoop 线程,只能阻塞等待
+        }
+        return sql != nullptr;
+    }
+
+    bool await_suspend(std::coroutine_handle<> hd) {
+        if (t_loop->IsStopped()) {
+            return false;  // Loop 已停止, 不再挂起, 按获取失败返回
+        }
+        waiter = std::make_shared<Waiter>();
+        waiter->handle = hd;
+        waiter->loop = t_loop;
+        if (timeoutMs >= 0) {
+            waiter->timerId = t_loop->NewTimerId();
+        }
+        if (!pool->Park(waiter)) {
+            return false;  // 登记前有连接被归还,不挂起
+        }
+        if (timeoutMs >= 0) {
+            // 定时器在本线程触发,与 FreeConn 的移交在 CancelWait 的锁内决出先后
+            t_loop->AddTimer(waiter->timerId, timeoutMs,
+                             [pool = pool, w = waiter]() {
+                                 if (pool->CancelWait(w)) w->handle.resume();
+                             });
+        }
+        // Loop 停止时同样经 CancelWait 与移交决出先后, 摘除成功才由这里恢复
+        stopReg = t_loop->getStopToken().OnCancel([pool = pool, w = waiter]() {
+            if (pool->CancelWait(w)) {
+                if (w->timerId != 0) w->loop->DelTimer(w->timerId);
+                w->handle.resume();
+            }
+        });
+        return true;
+    }
+
+    SqlConn await_resume() {
+        stopReg.Reset();
+        if (waiter != nullptr) {
+            sql = waiter->conn;
+        }
+        pool->RecordWait(Clock::now() - start, sql == nullptr);
+        return SqlConn(sql, pool);
+    }
+};
+
+inline SqlConnPool::AcquireAwaitable SqlConnPool::Acquire(int timeoutMs) {
+    return AcquireAwaitable{this, timeoutMs};
+}
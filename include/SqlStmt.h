@@ -0,0 +1,97 @@
+#pragma once
+#include <mysql/mysql.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 预处理语句 (MYSQL_STMT) 封装
+ * @details 参数通过二进制协议单独发送,不会与 SQL 文本拼接,天然防注入;
+ * 结果直接写入调用方提供的缓冲区,省去文本协议的结果转换.
+ * 用法:
+ *   stmt->BindParam(0, user);
+ *   stmt->BindResult(0, buf, sizeof(buf), &len);
+ *   if (stmt->Execute()) while (stmt->Fetch() == 1) { ... }
+ * 绑定的参数/结果缓冲区必须在 Execute/Fetch 期间保持有效
+ */
+class SqlStmt {
+public:
+    explicit SqlStmt(MYSQL_STMT* stmt);
+    ~SqlStmt();
+
+    // 禁止拷贝
+    SqlStmt(const SqlStmt&) = delete;
+    SqlStmt& operator=(const SqlStmt&) = delete;
+
+    // 绑定第 idx 个参数 (从 0 开始)
+    void BindParam(int idx, std::string_view value);
+    void BindParam(int idx, int64_t value);
+    void BindParam(int idx, double value);
+    void BindParamNull(int idx);
+
+    // 绑定第 idx 列结果: 字符串写入 buf (最多 cap 字节), *len 为实际长度 (可能大于 cap 表示截断)
+    void BindResult(int idx, char* buf, size_t cap, unsigned long* len, bool* isNull = nullptr);
+    void BindResult(int idx, int64_t* value, bool* isNull = nullptr);
+    void BindResult(int idx, double* value, bool* isNull = nullptr);
+
+    // 执行语句并把结果集缓存到客户端
+    bool Execute();
+
+    // 取下一行到绑定的缓冲区: 1 有数据, 0 没有更多行, -1 出错
+    int Fetch();
+
+    const char* Error() { return mysql_stmt_error(stmt_); }
+
+private:
+    // 参数值的存储: MYSQL_BIND 只保存指针
+    struct ParamValue {
+        int64_t i{0};
+        double d{0.0};
+        unsigned long len{0};
+        bool isNull{false};
+    };
+
+    MYSQL_STMT* stmt_;
+    std::vector<MYSQL_BIND> params_;
+    std::vector<ParamValue> paramValues_;
+    std::vector<MYSQL_BIND> results_;
+};
+
+/**
+ * @brief 单个 MySQL 连接的预处理语句缓存, 以 SQL 文本为键, 超过上限时淘汰最久未使用的语句
+ * 同一连接同一时刻只会被一个协程持有,所以缓存本身不加锁
+ */
+class SqlStmtCache {
+public:
+    explicit SqlStmtCache(MYSQL* sql) : sql_(sql) {}
+
+    /**
+     * @brief 获取 query 对应的预处理语句,首次使用时 prepare; 失败返回 nullptr
+     * @note 返回的指针在之后又有 MAX_STMTS_ 条其他语句被使用前一直有效 (LRU 只淘汰队尾),
+     * 一次持有连接期间用到的语句不会互相淘汰
+     */
+    SqlStmt* Get(const std::string& query);
+
+    // 关闭所有语句 (连接断开/重连时调用)
+    void Clear() {
+        stmts_.clear();
+        lru_.clear();
+    }
+
+private:
+    static const size_t MAX_STMTS_{64};
+
+    struct Entry {
+        std::unique_ptr<SqlStmt> stmt;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    MYSQL* sql_;
+    std::unordered_map<std::string, Entry> stmts_;
+    std::list<std::string> lru_;  // 队头最近使用
+};
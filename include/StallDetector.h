@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class EventLoop;
+
+/**
+ * @brief 卡顿检测: 找出阻塞了某个 Loop 线程的处理函数
+ * @details 后台线程每隔阈值的一半检查一次所有已登记的 Loop. 某一轮已运行超过阈值时,
+ * 记录 Loop 编号、正在恢复的协程地址和 fd, 并向该线程发送 SIGUSR2,
+ * 由信号处理函数把它当前的调用栈写到 stderr (每轮最多一次).
+ * Loop 开启埋点 (EventLoop::EnableInstrumentation) 时自动登记
+ * @note 信号会打断被卡住线程上的 sleep/poll 等调用 (返回 EINTR), 仅用于定位问题
+ */
+class StallDetector {
+public:
+    // 启动后台线程 (在创建 Worker 之前调用), thresholdMs <= 0 时不启动
+    static void Start(int thresholdMs);
+    static void Stop();
+
+    // Loop 启动/停止时在自己的线程上登记/注销
+    static void Register(EventLoop* loop);
+    static void Unregister(EventLoop* loop);
+
+    // 累计检测到的正在卡住的轮数
+    static uint64_t getDetectedCount() { return detected_.load(std::memory_order_relaxed); }
+
+private:
+    static void Watch(int thresholdMs);
+    static void DumpStack(int sig);
+
+    static inline std::mutex mutex_;
+    // Loop -> 上次已报告的那一轮的开始时间, 同一轮只报告一次
+    static inline std::unordered_map<EventLoop*, int64_t> loops_;
+    static inline std::thread thread_;
+    static inline std::atomic<bool> running_{false};
+    static inline std::atomic<uint64_t> detected_{0};
+};
@@ -11,6 +11,8 @@ using Clock = std::chrono::high_resolution_clock;
 using TimeStamp = std::chrono::high_resolution_clock::time_point;
 using MS = std::chrono::milliseconds;
 
+class Histogram;
+
 /**
  * @brief 定时器节点
  */
@@ -40,8 +42,8 @@ public:
     // 手动触发 id 对应的回调并删除
     void doWork(int id);
 
-    // 核心函数：检查并处理所有超时节点
-    void tick();
+    // 核心函数：检查并处理所有超时节点; lateness 非空时记录每个定时器比预定时间晚触发了多少 ns
+    void tick(Histogram* lateness = nullptr);
 
     void pop() {
         if (heap_.empty()) return;
@@ -51,6 +53,9 @@ public:
     // 获取下一次超时的毫秒数，用于 epoll_wait
     int GetNextTick();
 
+    // 当前定时器个数
+    size_t size() const { return heap_.size(); }
+
     void clear() {
         heap_.clear();
         id2Index.clear();
@@ -1,13 +1,16 @@
 #pragma once
 #include <sys/resource.h>
 #include <sys/sendfile.h>
+#include <unistd.h>
 
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <string>
 
 #include "Log.h"
+#include "Metrics.h"
 
 class Utils {
 public:
@@ -31,11 +34,23 @@ public:
                 return true;
             }
             remaining -= sent;
+            Metrics::Add(Metrics::kBytesSendfile, sent);
             LOG_INFO("[Sendfile]已传输Body: {}B, 剩余{}B", sent, remaining);
         }
         return true;
     }
 
+    // 当前进程常驻内存 (RSS) 字节数, 读取 /proc/self/statm 第二列 (页数), 失败返回 0
+    static size_t GetRssBytes() {
+        FILE* fp = fopen("/proc/self/statm", "r");
+        if (fp == nullptr) return 0;
+        unsigned long size = 0, resident = 0;
+        int ret = fscanf(fp, "%lu %lu", &size, &resident);
+        fclose(fp);
+        if (ret != 2) return 0;
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
     static void setRlimit() {
         // 将文件描述符限制提高到65535
         struct rlimit rlim;
@@ -0,0 +1,223 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Cancellation.h"
+#include "Result.h"
+
+namespace detail {
+
+// void 结果用 std::monostate 占位, 便于放进 tuple/vector
+template <typename T>
+struct ValueOf {
+    using type = T;
+};
+template <>
+struct ValueOf<void> {
+    using type = std::monostate;
+};
+template <typename T>
+using ValueOfT = typename ValueOf<T>::type;
+
+/**
+ * @brief 组合器内部的驱动协程: 负责 co_await 一个子任务
+ * 创建后挂起, Start() 启动; 结束时销毁自身帧, 并对称转移到 co_return 的协程 (等待方或 noop)
+ */
+struct Driver {
+    struct promise_type {
+        std::coroutine_handle<> next{std::noop_coroutine()};
+
+        static void* operator new(size_t size) { return FrameAllocator::Allocate(size); }
+        static void operator delete(void* ptr) noexcept { FrameAllocator::Deallocate(ptr); }
+
+        Driver get_return_object() {
+            return Driver{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            struct Awaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> hd) noexcept {
+                    std::coroutine_handle<> next = hd.promise().next;
+                    hd.destroy();  //! 销毁后不能再访问帧内任何成员
+                    return next;
+                }
+                void await_resume() noexcept {}
+            };
+            return Awaiter{};
+        }
+
+        void return_value(std::coroutine_handle<> hd) { next = hd; }
+        void unhandled_exception() noexcept { std::terminate(); }  // 驱动协程内部已捕获
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    void Start() { handle.resume(); }
+};
+
+/**
+ * @brief 计数门闩: n 个子任务 + 等待方自己共 n+1 个计数, 最后一个到达的负责恢复等待方.
+ * 等待方在启动完全部子任务后才释放自己的计数, 所以同步完成的子任务不会提前恢复它
+ */
+struct Latch {
+    std::atomic<size_t> count;
+    std::coroutine_handle<> waiter;
+
+    explicit Latch(size_t n) : count(n + 1) {}
+
+    std::coroutine_handle<> Arrive() {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) return waiter;
+        return std::noop_coroutine();
+    }
+};
+
+// 启动所有驱动协程并等待门闩
+template <typename Drivers>
+struct LatchAwaiter {
+    Latch& latch;
+    Drivers& drivers;
+
+    bool await_ready() { return false; }
+    bool await_suspend(std::coroutine_handle<> hd) {
+        latch.waiter = hd;
+        for (auto& driver : drivers) driver.Start();
+        return latch.count.fetch_sub(1, std::memory_order_acq_rel) > 1;  // 已全部完成则不挂起
+    }
+    void await_resume() {}
+};
+
+template <typename T>
+Driver WhenAllItem(Task<T> task, Latch& latch, std::optional<ValueOfT<T>>& out,
+                   std::exception_ptr& error) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            out.emplace();
+        } else {
+            out.emplace(co_await task);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    co_return latch.Arrive();
+}
+
+template <typename... Ts, size_t... I>
+Task<std::tuple<ValueOfT<Ts>...>> WhenAllImpl(std::index_sequence<I...>, Task<Ts>... tasks) {
+    Latch latch(sizeof...(Ts));
+    std::tuple<std::optional<ValueOfT<Ts>>...> results;
+    std::array<std::exception_ptr, sizeof...(Ts)> errors;
+    std::array<Driver, sizeof...(Ts)> drivers{
+        WhenAllItem(std::move(tasks), latch, std::get<I>(results), errors[I])...};
+    co_await LatchAwaiter<decltype(drivers)>{latch, drivers};
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    co_return std::tuple<ValueOfT<Ts>...>{std::move(*std::get<I>(results))...};
+}
+
+// WhenAny 的状态: 放在等待方的帧里, 等待方在全部子任务结束后才恢复, 所以引用始终有效
+template <typename T>
+struct AnyState {
+    Latch latch;
+    CancellationSource& cancel;
+    std::atomic<bool> done{false};
+    size_t index{0};
+    std::optional<ValueOfT<T>> value;
+    std::exception_ptr error;
+
+    AnyState(size_t n, CancellationSource& source) : latch(n), cancel(source) {}
+};
+
+template <typename T>
+Driver WhenAnyItem(Task<T> task, AnyState<T>& state, size_t index) {
+    std::optional<ValueOfT<T>> value;
+    std::exception_ptr error;
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            value.emplace();
+        } else {
+            value.emplace(co_await task);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    if (!state.done.exchange(true, std::memory_order_acq_rel)) {
+        // 胜出: 记录结果并通知其余任务尽快结束 (它们被取消后的结果/异常都丢弃)
+        state.index = index;
+        state.value = std::move(value);
+        state.error = error;
+        state.cancel.Cancel();
+    }
+    co_return state.latch.Arrive();
+}
+
+}  // namespace detail
+
+/**
+ * @brief 并发等待全部任务完成, 按参数顺序返回结果 (void 任务对应 std::monostate)
+ * 有任务抛出异常时, 等全部结束后重新抛出第一个
+ */
+template <typename... Ts>
+Task<std::tuple<detail::ValueOfT<Ts>...>> WhenAll(Task<Ts>... tasks) {
+    static_assert(sizeof...(Ts) > 0, "WhenAll needs at least one task");
+    return detail::WhenAllImpl(std::index_sequence_for<Ts...>{}, std::move(tasks)...);
+}
+
+// 同类型任务的批量版本
+template <typename T>
+Task<std::vector<detail::ValueOfT<T>>> WhenAll(std::vector<Task<T>> tasks) {
+    const size_t n = tasks.size();
+    detail::Latch latch(n);
+    std::vector<std::optional<detail::ValueOfT<T>>> results(n);
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<detail::Driver> drivers;
+    drivers.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        drivers.push_back(detail::WhenAllItem(std::move(tasks[i]), latch, results[i], errors[i]));
+    }
+    co_await detail::LatchAwaiter<decltype(drivers)>{latch, drivers};
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    std::vector<detail::ValueOfT<T>> values;
+    values.reserve(n);
+    for (auto& result : results) values.push_back(std::move(*result));
+    co_return values;
+}
+
+/**
+ * @brief 等待任意一个任务完成, 返回 {下标, 结果}; 该任务抛出的异常会重新抛出
+ * @details 第一个任务结束后立即调用 cancel.Cancel(), 但等待方要等全部任务结束才恢复:
+ * 落选的任务可以放心引用等待方帧里的变量, 不会在帧销毁后继续访问.
+ * 任务应把 cancel.Token() 放进自己的 IoOptions (或自行检查), 否则只能等它们自然结束
+ * @note 与 CancellationSource 一样只能在 Loop 线程使用; 所有任务都在该 Loop 上恢复
+ */
+template <typename T>
+Task<std::pair<size_t, detail::ValueOfT<T>>> WhenAny(std::vector<Task<T>> tasks,
+                                                     CancellationSource& cancel) {
+    if (tasks.empty()) {
+        throw std::invalid_argument("WhenAny needs at least one task");
+    }
+    detail::AnyState<T> state(tasks.size(), cancel);
+    std::vector<detail::Driver> drivers;
+    drivers.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        drivers.push_back(detail::WhenAnyItem(std::move(tasks[i]), state, i));
+    }
+    co_await detail::LatchAwaiter<decltype(drivers)>{state.latch, drivers};
+
+    if (state.error) std::rethrow_exception(state.error);
+    co_return std::pair<size_t, detail::ValueOfT<T>>{state.index, std::move(*state.value)};
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Chase-Lev 工作窃取双端队列 (按 Lê 等人的 C11 内存模型版本实现)
+ * @details 所属线程在底部 Push/Pop (LIFO, 缓存友好), 其他线程从顶部 Steal (FIFO).
+ * 只有队列里剩最后一个元素时, Pop 才需要和 Steal 做一次 CAS 竞争.
+ * 数组满时所属线程扩容为两倍; 窃取者可能仍在读旧数组, 所以旧数组留到析构时才释放
+ * @tparam T 元素类型, 需可平凡拷贝 (通常是指针)
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque needs a trivially copyable T");
+
+public:
+    // 初始容量向上取整为 2 的幂
+    explicit WorkStealingDeque(size_t capacity = 256) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        arrays_.push_back(std::make_unique<Array>(static_cast<int64_t>(cap)));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    // 禁止拷贝
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    //* 所属线程: 压入底部
+    void Push(T item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = Grow(a, t, b);
+        }
+        a->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    //* 所属线程: 从底部弹出, 空时返回 false
+    bool Pop(T& item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);  // 空
+            return false;
+        }
+        item = a->Get(b);
+        if (t == b) {
+            // 最后一个元素: 与窃取者竞争
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    //* 任意线程: 从顶部窃取, 空或竞争失败时返回 false
+    bool Steal(T& item) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Array* a = array_.load(std::memory_order_acquire);
+        T x = a->Get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        item = x;
+        return true;
+    }
+
+    // 近似值: 并发修改时只作参考
+    size_t Size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+    bool Empty() const { return Size() == 0; }
+
+private:
+    struct Array {
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Array(int64_t cap)
+            : capacity(cap), mask(cap - 1), slots(std::make_unique<std::atomic<T>[]>(cap)) {}
+
+        T Get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void Put(int64_t i, T x) { slots[i & mask].store(x, std::memory_order_relaxed); }
+    };
+
+    Array* Grow(Array* old, int64_t t, int64_t b) {
+        auto bigger = std::make_unique<Array>(old->capacity * 2);
+        for (int64_t i = t; i < b; ++i) {
+            bigger->Put(i, old->Get(i));
+        }
+        Array* a = bigger.get();
+        arrays_.push_back(std::move(bigger));
+        array_.store(a, std::memory_order_release);
+        return a;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};     // 窃取端, 多线程 CAS
+    alignas(64) std::atomic<int64_t> bottom_{0};  // 所属线程端
+    std::atomic<Array*> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_;  // 当前数组和扩容前的旧数组, 只由所属线程修改
+};
@@ -2,11 +2,13 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <vector>
 
+#include "Affinity.h"
 #include "EventLoop.h"
 
 // 引用 TLS 变量
@@ -14,15 +16,21 @@ extern thread_local EventLoop* t_loop;
 
 class Worker {
 public:
-    Worker() {
+    // id: Worker 编号,同时作为其 EventLoop 的 id (用于连接池分片等按线程划分的资源)
+    // cpus: 线程允许运行的核, 为空表示不绑定; numaLocal: 绑定单核时, 内存优先从该核的 NUMA 节点分配
+    explicit Worker(int id = -1, std::vector<int> cpus = {}, bool numaLocal = false) {
         // 启动线程
-        thread_ = std::thread([this]() {
-            //* 1. 在线程内创建 EventLoop
-            EventLoop loop;
+        thread_ = std::thread([this, id, cpus = std::move(cpus), numaLocal]() {
+            //* 0. 先绑核再创建 EventLoop: Loop 的缓冲区池、定时器堆等在首次访问时落在本地节点
+            if (Affinity::PinCurrentThread(cpus) && numaLocal && cpus.size() == 1 &&
+                Affinity::NodeCount() > 1) {
+                Affinity::PreferNode(Affinity::NodeOfCpu(cpus[0]));
+            }
+            //* 1. 在线程内创建 EventLoop (由 Worker 持有: 线程退出后 Loop 仍然有效,
+            //* 所有 Worker join 之后才析构, 其他 Worker 可以无锁地窃取它的任务)
+            loop_ = std::make_unique<EventLoop>(id);
             //* 2. 设置 TLS
-            t_loop = &loop;
-            //* 3. 保存指针供外部调用 (简化 先直接赋值)
-            this->loop_ = &loop;
+            t_loop = loop_.get();
             //* 4. 通知主线程: 我准备好了
             {
                 std::unique_lock<std::mutex> lock(mutex_);
@@ -30,7 +38,7 @@ public:
                 cv_.notify_one();
             }
             // 5. 开启循环
-            loop.Loop();
+            loop_->Loop();
         });
 
         // 等待线程启动完毕
@@ -39,18 +47,28 @@ public:
     }
 
     ~Worker() {
+        Stop();
+        Join();
+    }
+
+    // 通知循环退出 (不等待)
+    void Stop() {
         if (loop_ != nullptr) {
             loop_->Stop();    // 停止循环
             loop_->WakeUp();  // 醒来退出循环
         }
+    }
+
+    // 等待线程退出, EventLoop 保留到 Worker 析构
+    void Join() {
         if (thread_.joinable()) thread_.join();
     }
 
-    EventLoop* getLoop() { return loop_; }
+    EventLoop* getLoop() { return loop_.get(); }
 
 private:
     std::thread thread_;
-    EventLoop* loop_{nullptr};
+    std::unique_ptr<EventLoop> loop_;
     std::mutex mutex_;
     std::condition_variable cv_;
     std::atomic<bool> ready_{false};
@@ -0,0 +1,133 @@
+#include "Affinity.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Log.h"
+
+namespace {
+
+// <numaif.h> 属于 libnuma, 这里只需要一个常量
+constexpr int kMpolPreferred = 1;
+
+}  // namespace
+
+std::vector<int> Affinity::AvailableCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        LOG_ERROR("sched_getaffinity failed: {}", strerror(errno));
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+Affinity::Plan Affinity::MakePlan(const AffinityOptions& options) {
+    Plan plan;
+    std::vector<int> cpus = AvailableCpus();
+    if (cpus.empty()) {
+        plan.workerNum = 1;
+        return plan;
+    }
+    size_t reserved = options.reservedCores > 0 ? static_cast<size_t>(options.reservedCores) : 0;
+    if (reserved >= cpus.size()) {
+        reserved = 0;  // 核太少, 不预留
+    }
+    plan.reservedCpus.assign(cpus.begin(), cpus.begin() + reserved);
+    plan.workerPool.assign(cpus.begin() + reserved, cpus.end());
+    plan.workerNum = static_cast<int>(plan.workerPool.size());
+    if (options.pinWorkers) {
+        plan.workerCpus = plan.workerPool;
+    }
+    return plan;
+}
+
+bool Affinity::PinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+        LOG_ERROR("pthread_setaffinity_np failed: {}", strerror(ret));
+        return false;
+    }
+    return true;
+}
+
+int Affinity::NodeOfCpu(int cpu) {
+    // /sys/devices/system/cpu/cpuN/ 下有一个指向所属节点的 nodeM 链接
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return -1;
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' &&
+            entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+int Affinity::NodeCount() {
+    // 格式如 "0" 或 "0-1" 或 "0,2-3", 取最大编号 + 1
+    FILE* fp = fopen("/sys/devices/system/node/online", "r");
+    if (fp == nullptr) return 1;
+    char buf[128] = {0};
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    int maxNode = 0;
+    for (size_t i = 0; i < n;) {
+        if (buf[i] >= '0' && buf[i] <= '9') {
+            char* end = nullptr;
+            maxNode = std::max(maxNode, static_cast<int>(strtol(buf + i, &end, 10)));
+            i = end - buf;
+        } else {
+            ++i;
+        }
+    }
+    return maxNode + 1;
+}
+
+bool Affinity::PreferNode(int node) {
+    constexpr int kMaxNodes = sizeof(unsigned long) * 8;
+    if (node < 0 || node >= kMaxNodes) return false;
+    unsigned long mask = 1UL << node;
+    // 内核会把 maxnode 减一后再用, 所以多传一位
+    if (syscall(SYS_set_mempolicy, kMpolPreferred, &mask, kMaxNodes + 1) != 0) {
+        LOG_WARN("set_mempolicy(node {}) failed: {}", node, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int Affinity::GetIncomingCpu(int fd) {
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0) {
+        return cpu;
+    }
+#else
+    (void)fd;
+#endif
+    return -1;
+}
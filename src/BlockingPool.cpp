@@ -0,0 +1,89 @@
+#include "BlockingPool.h"
+
+#include "Log.h"
+
+void BlockingPool::Init(int threads, size_t maxQueue, std::function<void()> onThreadStart,
+                        std::function<void()> onThreadExit) {
+    if (running_.load(std::memory_order_acquire)) {
+        LOG_WARN("BlockingPool already initialized");
+        return;
+    }
+    if (threads <= 0 || maxQueue == 0) {
+        throw std::runtime_error("BlockingPool needs threads > 0 and maxQueue > 0");
+    }
+    maxQueue_ = maxQueue;
+    onThreadStart_ = std::move(onThreadStart);
+    onThreadExit_ = std::move(onThreadExit);
+    queue_ = std::make_unique<MpmcQueue<Job*>>(maxQueue);
+    running_.store(true, std::memory_order_release);
+    for (int i = 0; i < threads; ++i) {
+        threads_.emplace_back([this]() { WorkerThread(); });
+    }
+    LOG_INFO("BlockingPool started: {} threads, max queue {}", threads, maxQueue);
+}
+
+void BlockingPool::Shutdown() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    queue_->shutdown();  // 线程取完剩余任务后退出
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+    threads_.clear();
+}
+
+bool BlockingPool::Submit(Job* job) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    //* 先占一个排队名额: 超过上限直接拒绝 (MpmcQueue 的容量按 2 的幂取整, 不能直接当上限)
+    if (queued_.fetch_add(1, std::memory_order_relaxed) >= static_cast<int64_t>(maxQueue_)) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    job->enqueueNs = NowNs();
+    if (!queue_->try_push(job)) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void BlockingPool::WorkerThread() {
+    if (onThreadStart_) onThreadStart_();
+    Job* job = nullptr;
+    while (queue_->pop(job)) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        active_.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t start = NowNs();
+        uint64_t wait = static_cast<uint64_t>(start - job->enqueueNs);
+        waitNs_.fetch_add(wait, std::memory_order_relaxed);
+        uint64_t maxWait = maxWaitNs_.load(std::memory_order_relaxed);
+        while (wait > maxWait &&
+               !maxWaitNs_.compare_exchange_weak(maxWait, wait, std::memory_order_relaxed)) {
+        }
+
+        job->run(job);  //! 之后不能再访问 job
+
+        runNs_.fetch_add(static_cast<uint64_t>(NowNs() - start), std::memory_order_relaxed);
+        active_.fetch_sub(1, std::memory_order_relaxed);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (onThreadExit_) onThreadExit_();
+}
+
+BlockingPool::Stats BlockingPool::getStats() const {
+    return Stats{submitted_.load(std::memory_order_relaxed),
+                 rejected_.load(std::memory_order_relaxed),
+                 completed_.load(std::memory_order_relaxed),
+                 queued_.load(std::memory_order_relaxed),
+                 active_.load(std::memory_order_relaxed),
+                 waitNs_.load(std::memory_order_relaxed),
+                 runNs_.load(std::memory_order_relaxed),
+                 maxWaitNs_.load(std::memory_order_relaxed)};
+}
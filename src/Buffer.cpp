@@ -19,6 +19,15 @@ void Buffer::MakeSpace(size_t len) {
     }
 }
 
+void Buffer::Shrink(size_t reserve) {
+    size_t readable = ReadableBytes();
+    std::vector<char> buf(kCheapPrepend + readable + reserve);
+    std::copy(begin() + readerIndex_, begin() + writerIndex_, buf.begin() + kCheapPrepend);
+    buffer_.swap(buf);  // 旧内存随 buf 析构释放
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = readerIndex_ + readable;
+}
+
 // 利用栈空间临时缓冲区 (iovec),避免每次都分配大内存,又能一次性读完 socket 数据
 ssize_t Buffer::ReadFd(int fd, int *saveErrno) {
     char extrabuf[INT16_MAX];  // 64KB的栈空间
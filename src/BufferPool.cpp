@@ -0,0 +1,53 @@
+#include "BufferPool.h"
+
+#include <algorithm>
+
+BufferPool::Lease BufferPool::Acquire() {
+    std::unique_ptr<Buffer> buf;
+    if (!free_.empty()) {
+        buf = std::move(free_.back());
+        free_.pop_back();
+        idle_.store(free_.size(), std::memory_order_relaxed);
+        idleBytes_.fetch_sub(buf->Capacity(), std::memory_order_relaxed);
+    } else {
+        buf = std::make_unique<Buffer>();
+    }
+    size_t inUse = inUse_.load(std::memory_order_relaxed) + 1;
+    inUse_.store(inUse, std::memory_order_relaxed);
+    peakInUse_ = std::max(peakInUse_, inUse);
+    return Lease(this, std::move(buf));
+}
+
+void BufferPool::Recycle(std::unique_ptr<Buffer> buf) {
+    size_t inUse = inUse_.load(std::memory_order_relaxed) - 1;
+    inUse_.store(inUse, std::memory_order_relaxed);
+
+    buf->RetrieveAll();
+    //* 高水位收缩: 被大请求撑大的缓冲区不再保留大块内存
+    if (buf->Capacity() > kHighWater) {
+        buf->Shrink();
+        shrinks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //* 周期裁剪: 只保留上一周期峰值所需的空闲缓冲区
+    Clock::time_point now = Clock::now();
+    if (now - lastTrim_ >= std::chrono::milliseconds(kTrimIntervalMs)) {
+        Trim(peakInUse_ > inUse ? peakInUse_ - inUse : 0);
+        peakInUse_ = inUse;
+        lastTrim_ = now;
+    }
+
+    if (free_.size() < kMaxIdle) {
+        idleBytes_.fetch_add(buf->Capacity(), std::memory_order_relaxed);
+        free_.push_back(std::move(buf));
+        idle_.store(free_.size(), std::memory_order_relaxed);
+    }
+}
+
+void BufferPool::Trim(size_t keep) {
+    while (free_.size() > keep) {
+        idleBytes_.fetch_sub(free_.back()->Capacity(), std::memory_order_relaxed);
+        free_.pop_back();
+    }
+    idle_.store(free_.size(), std::memory_order_relaxed);
+}
@@ -0,0 +1,139 @@
+#include "ChainBuffer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// 每个线程一个空闲 slab 池: 分配/释放都不加锁
+struct SlabPool {
+    std::vector<char*> free;
+    ~SlabPool() {
+        for (char* slab : free) delete[] slab;
+    }
+};
+
+thread_local SlabPool t_slabPool;
+
+}  // namespace
+
+char* ChainBuffer::AllocSlab() {
+    if (!t_slabPool.free.empty()) {
+        char* slab = t_slabPool.free.back();
+        t_slabPool.free.pop_back();
+        return slab;
+    }
+    return new char[kSlabSize];
+}
+
+void ChainBuffer::FreeSlab(char* slab) {
+    if (t_slabPool.free.size() < kMaxPooledSlabs) {
+        t_slabPool.free.push_back(slab);
+    } else {
+        delete[] slab;
+    }
+}
+
+ChainBuffer::ChainBuffer(ChainBuffer&& other) noexcept
+    : segs_(std::move(other.segs_)), readable_(other.readable_) {
+    other.segs_.clear();
+    other.readable_ = 0;
+}
+
+ChainBuffer& ChainBuffer::operator=(ChainBuffer&& other) noexcept {
+    if (this != &other) {
+        RetrieveAll();
+        segs_ = std::move(other.segs_);
+        readable_ = other.readable_;
+        other.segs_.clear();
+        other.readable_ = 0;
+    }
+    return *this;
+}
+
+void ChainBuffer::Append(const char* data, size_t len) {
+    readable_ += len;
+    while (len > 0) {
+        if (segs_.empty() || segs_.back().end == kSlabSize) {
+            segs_.push_back({AllocSlab(), 0, 0});
+        }
+        Segment& tail = segs_.back();
+        size_t n = std::min(len, kSlabSize - tail.end);
+        std::memcpy(tail.slab + tail.end, data, n);
+        tail.end += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void ChainBuffer::Retrieve(size_t len) {
+    if (len >= readable_) {
+        RetrieveAll();
+        return;
+    }
+    readable_ -= len;
+    while (len > 0) {
+        Segment& head = segs_.front();
+        size_t n = std::min(len, head.end - head.begin);
+        head.begin += n;
+        len -= n;
+        // 读完的 slab 整块归还 (最后一块还可能继续写, 只重置位置)
+        if (head.begin == head.end) {
+            if (segs_.size() > 1) {
+                FreeSlab(head.slab);
+                segs_.pop_front();
+            } else {
+                head.begin = head.end = 0;
+            }
+        }
+    }
+}
+
+void ChainBuffer::RetrieveAll() {
+    for (auto& seg : segs_) {
+        FreeSlab(seg.slab);
+    }
+    segs_.clear();
+    readable_ = 0;
+}
+
+std::string ChainBuffer::RetrieveAllToStr() {
+    std::string str;
+    str.reserve(readable_);
+    for (auto& seg : segs_) {
+        str.append(seg.slab + seg.begin, seg.end - seg.begin);
+    }
+    RetrieveAll();
+    return str;
+}
+
+int ChainBuffer::GetIoVec(struct iovec* vec, int maxCnt) const {
+    int cnt = 0;
+    for (auto it = segs_.begin(); it != segs_.end() && cnt < maxCnt; ++it) {
+        if (it->end > it->begin) {
+            vec[cnt].iov_base = it->slab + it->begin;
+            vec[cnt].iov_len = it->end - it->begin;
+            ++cnt;
+        }
+    }
+    return cnt;
+}
+
+ssize_t ChainBuffer::WriteFd(int fd, int* saveErrno) {
+    struct iovec vec[kMaxWriteIov];
+    int cnt = GetIoVec(vec, kMaxWriteIov);
+    if (cnt == 0) {
+        return 0;
+    }
+    const ssize_t n = writev(fd, vec, cnt);
+    if (n < 0) {
+        *saveErrno = errno;
+        return n;
+    }
+    Retrieve(static_cast<size_t>(n));
+    return n;
+}
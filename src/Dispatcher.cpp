@@ -0,0 +1,144 @@
+#include "Dispatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// murmur3 的 32 位收尾混合, 让相邻 IP / 虚拟节点编号在环上均匀散开
+uint32_t Mix32(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+}  // namespace
+
+Dispatcher::Dispatcher(std::vector<EventLoop*> loops, Policy policy, int virtualNodes)
+    : loops_(std::move(loops)), policy_(policy) {
+    if (loops_.empty()) {
+        throw std::runtime_error("Dispatcher needs at least one loop");
+    }
+    if (policy_ == Policy::ConsistentHash) {
+        ring_.reserve(loops_.size() * virtualNodes);
+        for (size_t i = 0; i < loops_.size(); ++i) {
+            for (int v = 0; v < virtualNodes; ++v) {
+                ring_.emplace_back(Mix32(static_cast<uint32_t>(i) * 0x9e3779b9u + v), i);
+            }
+        }
+        std::sort(ring_.begin(), ring_.end());
+    }
+}
+
+void Dispatcher::SetWorkerCpus(const std::vector<int>& cpus) {
+    cpuToWorker_.clear();
+    for (size_t i = 0; i < cpus.size() && i < loops_.size(); ++i) {
+        if (cpus[i] < 0) continue;
+        if (static_cast<size_t>(cpus[i]) >= cpuToWorker_.size()) {
+            cpuToWorker_.resize(cpus[i] + 1, -1);
+        }
+        cpuToWorker_[cpus[i]] = static_cast<int>(i);
+    }
+}
+
+size_t Dispatcher::Pick(const sockaddr_in& peer, int incomingCpu) {
+    size_t index = 0;
+    //* 网卡 RX 队列对齐: 连接交给处理它入站包的那个核上的 Worker, 协议栈和业务共享缓存
+    if (incomingCpu >= 0 && static_cast<size_t>(incomingCpu) < cpuToWorker_.size() &&
+        cpuToWorker_[incomingCpu] >= 0 && WithinBoundedLoad(cpuToWorker_[incomingCpu])) {
+        index = cpuToWorker_[incomingCpu];
+    } else if (loops_.size() > 1) {
+        switch (policy_) {
+            case Policy::RoundRobin:
+                index = next_;
+                next_ = (next_ + 1) % loops_.size();
+                break;
+            case Policy::LeastConnections:
+                index = PickLeastConnections();
+                break;
+            case Policy::PowerOfTwo:
+                index = PickPowerOfTwo();
+                break;
+            case Policy::ConsistentHash:
+                index = PickConsistentHash(ntohl(peer.sin_addr.s_addr));
+                break;
+        }
+    }
+    loops_[index]->AddConnections(1);
+    return index;
+}
+
+size_t Dispatcher::PickLeastConnections() const {
+    // 连接数相同时取下标最小的: Pick 会立即给它 +1, 下一个连接自然落到别处
+    size_t best = 0;
+    int bestConns = loops_[0]->getConnections();
+    for (size_t i = 1; i < loops_.size(); ++i) {
+        int conns = loops_[i]->getConnections();
+        if (conns < bestConns) {
+            best = i;
+            bestConns = conns;
+        }
+    }
+    return best;
+}
+
+size_t Dispatcher::PickPowerOfTwo() {
+    const auto n = static_cast<uint32_t>(loops_.size());
+    size_t a = NextRandom() % n;
+    size_t b = NextRandom() % (n - 1);
+    if (b >= a) ++b;  // 保证两个候选不同
+    int depthA = loops_[a]->getQueueDepth();
+    int depthB = loops_[b]->getQueueDepth();
+    if (depthA != depthB) {
+        return depthA < depthB ? a : b;
+    }
+    return loops_[a]->getConnections() <= loops_[b]->getConnections() ? a : b;
+}
+
+size_t Dispatcher::PickConsistentHash(uint32_t ip) const {
+    uint32_t h = Mix32(ip);
+    auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(h, size_t{0}));
+    size_t pos = it == ring_.end() ? 0 : static_cast<size_t>(it - ring_.begin());
+
+    // 有界负载: 热点 IP 不会把一个 Worker 压垮, 超限时顺延, 大多数客户端仍保持固定映射
+    for (size_t step = 0; step < ring_.size(); ++step) {
+        size_t index = ring_[(pos + step) % ring_.size()].second;
+        if (WithinBoundedLoad(index)) {
+            return index;
+        }
+    }
+    return ring_[pos].second;
+}
+
+bool Dispatcher::WithinBoundedLoad(size_t index) const {
+    long total = 0;
+    for (EventLoop* loop : loops_) total += loop->getConnections();
+    const double limit =
+        std::ceil(kBoundedLoadFactor * static_cast<double>(total + 1) / loops_.size());
+    return loops_[index]->getConnections() + 1 <= limit;
+}
+
+uint32_t Dispatcher::NextRandom() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return rng_;
+}
+
+std::string_view Dispatcher::PolicyName(Policy policy) {
+    switch (policy) {
+        case Policy::RoundRobin:
+            return "round-robin";
+        case Policy::LeastConnections:
+            return "least-conn";
+        case Policy::PowerOfTwo:
+            return "power-of-two";
+        case Policy::ConsistentHash:
+            return "ip-hash";
+    }
+    return "unknown";
+}
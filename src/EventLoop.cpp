@@ -2,6 +2,11 @@
 
 #include <sstream>
 
+#include "Scheduler.h"
+#include "StallDetector.h"
+
+thread_local EventLoop* t_loop = nullptr;  // 线程局部变量,每个线程有一份独立的,全局可访问
+
 // 核心循环
 void EventLoop::Loop() {
     // 把 wakeup_fd 加入 epoll
@@ -13,6 +18,14 @@ void EventLoop::Loop() {
     std::string id_str = oss.str();
     LOG_INFO("EventLoop Started in thread {}", id_str);
 
+    thread_ = pthread_self();
+    const bool instrument = IsInstrumented();
+    const int64_t stallNs = getStallThresholdNs();
+    if (instrument && stallNs > 0) {
+        StallDetector::Register(this);
+    }
+
+    bool moreJobs = false;  // 上一轮计算任务因达到上限停下
     while (!stop_) {
         is_sleeping_ = true;  // 睡前标记
         //* 1. 获取下一个超时时间 (ms)
@@ -21,46 +34,197 @@ void EventLoop::Loop() {
         if (timer_ != nullptr) {
             timeout = timer_->GetNextTick();
         }
+        //! 睡前再检查一次任务队列: RunInLoop 可能在 is_sleeping_ 置位前投递了任务,
+        //! 那次投递不会 WakeUp,这里不检查就会一直睡到下一个事件
+        //! 本 Loop 还有计算任务、或上一轮窃取到上限 (victim 可能还有积压) 时也不能睡
+        //! (其他 Worker 投递任务时由 JobPosted 叫醒睡眠的 Loop)
+        if (HasPendingTasks() || !runQueue_.Empty() || moreJobs) {
+            timeout = 0;
+        }
 
         //* 2. 阻塞等待 IO 事件,最多等 timeout 毫秒
         auto events = epoll_.Wait(timeout);  // 阻塞等待,直到有fd就绪,释放CPU,不空转
 
         is_sleeping_ = false;  // 醒来标记
 
+        int64_t start = 0;
+        if (instrument) {
+            start = NowNs();
+            iteration_start_ns_.store(start, std::memory_order_relaxed);
+            stats_.events.Record(events.size());
+        }
+
         //* 3. 处理 IO 事件
         for (auto& ev : events) {
             if (ev.data.fd == wakeup_fd_) {
-                // 如果是唤醒事件,读一下 buffer 清空
+                // 如果是唤醒事件,读一下 buffer 清空,任务统一在下面执行
                 uint64_t zero{0UL};
                 read(wakeup_fd_, &zero, sizeof(zero));
-                // 然后执行队列任务
-                ExecuteTasks();
             } else {
                 // 普通 socket 事件
                 // ... 处理协程 resume ...
                 // 查找在这个 fd 上等待的协程
-                int fd = ev.data.fd;
-                if (auto it = waiting_coroutines_.find(fd);
-                    it != waiting_coroutines_.end()) {  // C++17 if初始化
-                    auto handle = it->second;
-                    waiting_coroutines_.erase(it);
-                    handle.resume();  // 唤醒协程
-                }
+                Wake(ev.data.fd, 0, 0);  // 唤醒协程
             }
         }
 
-        //* 4. 处理定时器超时
+        //* 4. 执行队列任务 (跨线程投递的连接、协程恢复等)
+        size_t tasks = ExecuteTasks();
+
+        //* 5. 运行计算任务, 本地没有时帮其他 Worker 分担
+        moreJobs = RunJobs();
+
+        //* 6. 处理定时器超时
         if (timer_ != nullptr) {
-            timer_->tick();
+            timer_->tick(instrument ? &stats_.timerLateNs : nullptr);
+            SyncTimerCount();
+        }
+
+        //* 7. 记录本轮耗时, 超过阈值时记一条卡顿日志 (正在卡住时的调用栈由 StallDetector 抓取)
+        if (instrument) {
+            auto elapsed = NowNs() - start;
+            iteration_start_ns_.store(0, std::memory_order_relaxed);
+            stats_.iterationNs.Record(static_cast<uint64_t>(elapsed));
+            if (stallNs > 0 && elapsed > stallNs) {
+                stats_.stalls.fetch_add(1, std::memory_order_relaxed);
+                LOG_WARN("[Stall] loop {} iteration took {:.1f} ms ({} events, {} tasks)", id_,
+                         elapsed / 1e6, events.size(), tasks);
+            }
+        }
+    }
+
+    if (instrument && stallNs > 0) {
+        StallDetector::Unregister(this);
+    }
+
+    //* 8. 停止后收尾, 不留下挂起的协程
+    Drain();
+}
+
+EventLoop::~EventLoop() {
+    //! Worker 在所有线程 join 之后才销毁 Loop, 此时只有当前线程访问它;
+    //! 借用 t_loop 让被恢复的协程仍认为自己在本 Loop 上
+    EventLoop* saved = t_loop;
+    t_loop = this;
+    Drain();
+    t_loop = saved;
+    close(wakeup_fd_);
+}
+
+void EventLoop::Drain() {
+    // 通知在连接池/查询缓存上等待的协程 (回调把它们摘下并以失败恢复)
+    stopSource_.Cancel();
+    // 恢复的协程可能再投递任务或结束连接, 反复处理直到一轮没有任何工作
+    bool busy = true;
+    while (busy) {
+        busy = ExecuteTasks() > 0;
+        // 剩余的计算任务在本线程跑完 (其他 Worker 可能仍在窃取, Chase-Lev 队列允许并发)
+        StealableJob* job = nullptr;
+        while (runQueue_.Pop(job)) {
+            Scheduler::JobTaken();
+            job->run(job, this);
+            busy = true;
+        }
+        // 以 ECANCELED 恢复挂在 fd 上的协程; stop_ 已置位, 恢复后无法再次挂起到本 Loop
+        while (!waiting_coroutines_.empty()) {
+            auto it = waiting_coroutines_.begin();
+            Wake(it->first, it->second.seq, ECANCELED);
+            busy = true;
         }
     }
 }
 
+bool EventLoop::WaitFor(int fd, std::coroutine_handle<> handle, int* err,
+                        const IoOptions& opts) {
+    int errCode = 0;
+    if (stop_ || opts.token.IsCancelled()) {
+        errCode = ECANCELED;
+    } else if (opts.deadline.Expired()) {
+        errCode = ETIMEDOUT;
+    }
+    if (errCode != 0) {
+        if (err != nullptr) *err = errCode;
+        return false;
+    }
+
+    Parked& parked = waiting_coroutines_[fd];
+    if (parked.timerId != 0) {
+        DelTimer(parked.timerId);  // 覆盖了旧的等待
+    }
+    const uint64_t seq = ++next_wait_seq_;
+    parked.handle = handle;
+    parked.err = err;
+    parked.seq = seq;
+    parked.timerId = 0;
+    if (!opts.deadline.IsNever()) {
+        parked.timerId = NewTimerId();
+        AddTimer(parked.timerId, opts.deadline.RemainingMs(),
+                 [this, fd, seq]() { Wake(fd, seq, ETIMEDOUT); });
+    }
+    parked.registration = opts.token.OnCancel([this, fd, seq]() { Wake(fd, seq, ECANCELED); });
+    return true;
+}
+
+void EventLoop::PostJob(StealableJob* job) {
+    runQueue_.Push(job);
+    Scheduler::JobPosted(this);
+}
+
+bool EventLoop::RunJobs() {
+    StealableJob* job = nullptr;
+    int ran = 0;
+    while (ran < kMaxJobsPerTick && runQueue_.Pop(job)) {
+        Scheduler::JobTaken();
+        job->run(job, this);
+        ++ran;
+    }
+    if (ran > 0 || id_ < 0) {
+        return ran == kMaxJobsPerTick;
+    }
+    //* 本地为空: 只要还能窃取到就继续, 帮 victim 消化积压, 而不是等下一次 JobPosted
+    while (ran < kMaxJobsPerTick && Scheduler::Steal(this, job)) {
+        job->run(job, this);
+        ++ran;
+    }
+    return ran == kMaxJobsPerTick;
+}
+
+void EventLoop::CancelWait(int fd, int errCode) { Wake(fd, 0, errCode); }
+
+void EventLoop::Wake(int fd, uint64_t seq, int errCode) {
+    auto it = waiting_coroutines_.find(fd);
+    if (it == waiting_coroutines_.end() || (seq != 0 && it->second.seq != seq)) {
+        return;
+    }
+    Parked parked = std::move(it->second);
+    waiting_coroutines_.erase(it);
+    if (parked.timerId != 0) {
+        DelTimer(parked.timerId);
+    }
+    parked.registration.Reset();
+    if (errCode != 0 && parked.err != nullptr) {
+        *parked.err = errCode;
+    }
+    if (!IsInstrumented()) {
+        parked.handle.resume();
+        return;
+    }
+    // 记下正在运行的协程, 卡顿时 StallDetector 据此定位是哪个连接的处理函数 (可能嵌套恢复, 结束后还原)
+    void* prevCoroutine = current_coroutine_.load(std::memory_order_relaxed);
+    int prevFd = current_fd_.load(std::memory_order_relaxed);
+    current_coroutine_.store(parked.handle.address(), std::memory_order_relaxed);
+    current_fd_.store(fd, std::memory_order_relaxed);
+    parked.handle.resume();
+    current_coroutine_.store(prevCoroutine, std::memory_order_relaxed);
+    current_fd_.store(prevFd, std::memory_order_relaxed);
+}
+
 // 添加任务到队列,并唤醒 Loop
 void EventLoop::RunInLoop(std::function<void()> task) {  // 包装成统一对象
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        tasks_.push_back(task);
+        tasks_.push_back({std::move(task), IsInstrumented() ? NowNs() : 0});
+        queued_tasks_.fetch_add(1, std::memory_order_relaxed);  // 锁内计数, 与 ExecuteTasks 的扣减配对
     }
     // 只有子线程在睡觉时,才需要叫醒!
     if (is_sleeping_.load(std::memory_order_relaxed)) {
@@ -0,0 +1,255 @@
+#include "FrameAllocator.h"
+
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+constexpr int kLargeClass = FrameAllocator::kNumClasses;  // 超过最大级别, 直接走系统分配
+
+struct ThreadCache;
+
+// 每块内存的头部, 紧接着是协程帧
+struct BlockHeader {
+    ThreadCache* owner;  // 所属线程缓存, nullptr 表示线程退出后分配的
+    uint32_t cls;        // 尺寸级别
+    uint32_t size;       // 帧大小 (统计用)
+};
+static_assert(sizeof(BlockHeader) <= FrameAllocator::kHeaderSize, "header too large");
+
+// 所属线程持有的引用偏置: 线程存活期间跨线程释放只做减法, 引用不会归零
+constexpr long kOwnerBias = 1L << 40;
+
+struct ThreadCache {
+    BlockHeader* free[FrameAllocator::kNumClasses]{};
+    size_t freeCount[FrameAllocator::kNumClasses]{};
+    // 以下计数只由所属线程修改 (普通写入), 其他线程只在统计时读取
+    std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> poolHits{0};
+    std::atomic<uint64_t> localFrees{0};
+    std::atomic<uint64_t> allocBytes{0};
+    std::atomic<uint64_t> localFreeBytes{0};
+
+    // 其他线程释放的块: 多个线程 CAS 压栈, 只有所属线程整体取走 (exchange), 不存在 ABA 问题
+    alignas(64) std::atomic<BlockHeader*> remote{nullptr};
+    // kOwnerBias - 跨线程释放数; 线程退出时换算为存活块数, 归零时由最后一个释放者回收本结构
+    std::atomic<long> refs{kOwnerBias};
+    std::atomic<uint64_t> remoteFrees{0};
+    std::atomic<uint64_t> remoteFreeBytes{0};
+};
+
+// 只由所属线程调用的计数, 不需要原子读改写
+void Bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// 所有线程缓存的登记表 (只用于统计), 故意不析构, 避免进程退出时的析构顺序问题
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCache*> caches;
+    FrameAllocator::Stats retired;  // 已回收线程缓存的累计值
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+thread_local ThreadCache* t_cache = nullptr;
+thread_local bool t_exited = false;
+
+size_t BlockSize(int cls) { return FrameAllocator::kMinBlock << cls; }
+
+// 每个级别最多缓存 kMaxCachedBytes 字节的空闲块
+size_t MaxCached(int cls) { return FrameAllocator::kMaxCachedBytes / BlockSize(cls); }
+
+int ClassOf(size_t total) {
+    int cls = 0;
+    while (cls < FrameAllocator::kNumClasses && BlockSize(cls) < total) ++cls;
+    return cls;
+}
+
+// 空闲块复用帧的位置存放 next 指针
+BlockHeader*& NextOf(BlockHeader* h) {
+    return *reinterpret_cast<BlockHeader**>(reinterpret_cast<char*>(h) +
+                                            FrameAllocator::kHeaderSize);
+}
+
+void FreeList(BlockHeader* h) {
+    while (h != nullptr) {
+        BlockHeader* next = NextOf(h);
+        ::operator delete(h);
+        h = next;
+    }
+}
+
+// 放回本线程链表, 超过上限直接归还系统
+void PushLocal(ThreadCache* cache, BlockHeader* h) {
+    if (cache->freeCount[h->cls] < MaxCached(h->cls)) {
+        NextOf(h) = cache->free[h->cls];
+        cache->free[h->cls] = h;
+        ++cache->freeCount[h->cls];
+    } else {
+        ::operator delete(h);
+    }
+}
+
+// 取回其他线程释放的块
+void DrainRemote(ThreadCache* cache) {
+    BlockHeader* h = cache->remote.exchange(nullptr, std::memory_order_acquire);
+    while (h != nullptr) {
+        BlockHeader* next = NextOf(h);
+        PushLocal(cache, h);
+        h = next;
+    }
+}
+
+void DestroyCache(ThreadCache* cache) {
+    FreeList(cache->remote.exchange(nullptr, std::memory_order_acquire));
+    Registry& registry = GetRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.retired.allocs += cache->allocs.load(std::memory_order_relaxed);
+        registry.retired.poolHits += cache->poolHits.load(std::memory_order_relaxed);
+        registry.retired.remoteFrees += cache->remoteFrees.load(std::memory_order_relaxed);
+        std::erase(registry.caches, cache);
+    }
+    delete cache;
+}
+
+void Unref(ThreadCache* cache, long n) {
+    if (cache->refs.fetch_sub(n, std::memory_order_acq_rel) == n) {
+        DestroyCache(cache);
+    }
+}
+
+// 线程退出时释放空闲块并放弃所属线程的引用, 还有帧存活时由最后一个释放者回收
+struct CacheHolder {
+    ~CacheHolder() {
+        ThreadCache* cache = t_cache;
+        t_cache = nullptr;
+        t_exited = true;
+        if (cache == nullptr) return;
+        for (int cls = 0; cls < FrameAllocator::kNumClasses; ++cls) {
+            FreeList(cache->free[cls]);
+            cache->free[cls] = nullptr;
+            cache->freeCount[cls] = 0;
+        }
+        FreeList(cache->remote.exchange(nullptr, std::memory_order_acquire));
+        // 偏置换算为本线程分配且未在本线程释放的块数 (其中跨线程释放的已经减过)
+        long ownLive = static_cast<long>(cache->allocs.load(std::memory_order_relaxed) -
+                                         cache->localFrees.load(std::memory_order_relaxed));
+        Unref(cache, kOwnerBias - ownLive);
+    }
+};
+
+ThreadCache* LocalCache() {
+    if (t_cache == nullptr && !t_exited) {
+        static thread_local CacheHolder holder;  // 首次使用时构造, 线程退出时析构
+        (void)holder;
+        t_cache = new ThreadCache;
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.caches.push_back(t_cache);
+    }
+    return t_cache;
+}
+
+}  // namespace
+
+void* FrameAllocator::Allocate(size_t size) {
+    const size_t total = size + kHeaderSize;
+    ThreadCache* cache = LocalCache();
+    int cls = ClassOf(total);
+    BlockHeader* h = nullptr;
+
+    if (cache == nullptr) {
+        //! 线程正在退出 (thread_local 已析构), 不再经过缓存
+        h = static_cast<BlockHeader*>(::operator new(total));
+        h->owner = nullptr;
+        h->cls = kLargeClass;
+        h->size = static_cast<uint32_t>(size);
+        return reinterpret_cast<char*>(h) + kHeaderSize;
+    }
+
+    if (cls < kNumClasses) {
+        if (cache->free[cls] == nullptr) {
+            DrainRemote(cache);
+        }
+        if (cache->free[cls] != nullptr) {
+            h = cache->free[cls];
+            cache->free[cls] = NextOf(h);
+            --cache->freeCount[cls];
+            Bump(cache->poolHits);
+        } else {
+            h = static_cast<BlockHeader*>(::operator new(BlockSize(cls)));
+        }
+    } else {
+        h = static_cast<BlockHeader*>(::operator new(total));
+    }
+
+    h->owner = cache;
+    h->cls = static_cast<uint32_t>(cls);
+    h->size = static_cast<uint32_t>(size);
+    Bump(cache->allocs);
+    Bump(cache->allocBytes, size);
+    return reinterpret_cast<char*>(h) + kHeaderSize;
+}
+
+void FrameAllocator::Deallocate(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    BlockHeader* h = reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - kHeaderSize);
+    ThreadCache* owner = h->owner;
+    const uint32_t size = h->size;
+    if (owner == nullptr) {
+        ::operator delete(h);
+        return;
+    }
+
+    if (owner == t_cache) {
+        //* 本线程释放: 放回本地链表
+        if (h->cls < static_cast<uint32_t>(kNumClasses)) {
+            PushLocal(owner, h);
+        } else {
+            ::operator delete(h);
+        }
+        Bump(owner->localFrees);
+        Bump(owner->localFreeBytes, size);
+        return;
+    }
+
+    //* 跨线程释放: 压入所属线程的远端栈
+    owner->remoteFrees.fetch_add(1, std::memory_order_relaxed);
+    owner->remoteFreeBytes.fetch_add(size, std::memory_order_relaxed);
+    if (h->cls < static_cast<uint32_t>(kNumClasses)) {
+        BlockHeader* head = owner->remote.load(std::memory_order_relaxed);
+        do {
+            NextOf(h) = head;
+        } while (!owner->remote.compare_exchange_weak(head, h, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    } else {
+        ::operator delete(h);
+    }
+    Unref(owner, 1);
+}
+
+FrameAllocator::Stats FrameAllocator::getStats() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Stats stats = registry.retired;
+    for (ThreadCache* cache : registry.caches) {
+        uint64_t allocs = cache->allocs.load(std::memory_order_relaxed);
+        uint64_t frees = cache->localFrees.load(std::memory_order_relaxed) +
+                         cache->remoteFrees.load(std::memory_order_relaxed);
+        uint64_t bytes = cache->allocBytes.load(std::memory_order_relaxed);
+        uint64_t freeBytes = cache->localFreeBytes.load(std::memory_order_relaxed) +
+                             cache->remoteFreeBytes.load(std::memory_order_relaxed);
+        stats.liveFrames += allocs > frees ? allocs - frees : 0;
+        stats.liveBytes += bytes > freeBytes ? bytes - freeBytes : 0;
+        stats.allocs += cache->allocs.load(std::memory_order_relaxed);
+        stats.poolHits += cache->poolHits.load(std::memory_order_relaxed);
+        stats.remoteFrees += cache->remoteFrees.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
@@ -0,0 +1,170 @@
+#include "Histogram.h"
+
+#include <fmt/format.h>
+
+#include <memory>
+#include <mutex>
+
+namespace {
+
+constexpr std::array<const char*, RouteLatency::kPhaseNum> kPhaseNames{
+        "parse", "handler", "db_wait", "db_query", "last_byte"};
+
+// 一个线程的直方图表: [路由][阶段], 首次记录时才分配
+struct Table {
+    std::mutex growMutex;  // 所属线程扩表 与 抓取线程读表 互斥 (扩表只在首次记录新路由时发生)
+    std::vector<std::unique_ptr<Histogram>> histograms;
+};
+
+// 路由表和所有线程的直方图表, 故意不析构, 避免进程退出时与线程退出的析构顺序问题
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> routes{"other"};
+    std::vector<Table*> tables;
+    std::vector<Histogram::Snapshot> retired;  // 已退出线程的累计值, 按 [路由][阶段] 排列
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+thread_local Table* t_table = nullptr;
+
+// 线程退出时把直方图并入累计值并注销
+struct TableHolder {
+    Table* table{nullptr};
+    ~TableHolder() {
+        if (table == nullptr) return;
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t i = 0; i < table->histograms.size(); ++i) {
+            if (table->histograms[i] == nullptr) continue;
+            if (registry.retired.size() <= i) registry.retired.resize(i + 1);
+            table->histograms[i]->AddTo(registry.retired[i]);
+        }
+        std::erase(registry.tables, table);
+        delete table;
+        t_table = nullptr;
+    }
+};
+
+Table* LocalTable() {
+    if (t_table != nullptr) return t_table;
+    thread_local TableHolder holder;
+    auto* table = new Table;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.tables.push_back(table);
+    }
+    holder.table = table;
+    t_table = table;
+    return table;
+}
+
+}  // namespace
+
+int RouteLatency::Register(std::string_view route) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t i = 0; i < registry.routes.size(); ++i) {
+        if (registry.routes[i] == route) return static_cast<int>(i);
+    }
+    registry.routes.emplace_back(route);
+    return static_cast<int>(registry.routes.size() - 1);
+}
+
+int RouteLatency::Find(std::string_view path) {
+    // 路由在服务开始前注册完毕, 之后只读
+    const auto& routes = GetRegistry().routes;
+    for (size_t i = 1; i < routes.size(); ++i) {
+        if (routes[i] == path) return static_cast<int>(i);
+    }
+    return 0;
+}
+
+void RouteLatency::Record(int route, Phase phase, uint64_t ns) {
+    Table* table = LocalTable();
+    size_t index = static_cast<size_t>(route) * kPhaseNum + phase;
+    if (index >= table->histograms.size() || table->histograms[index] == nullptr) {
+        std::lock_guard<std::mutex> lock(table->growMutex);
+        if (index >= table->histograms.size()) table->histograms.resize(index + 1);
+        table->histograms[index] = std::make_unique<Histogram>();
+    }
+    table->histograms[index]->Record(ns);
+}
+
+Histogram::Snapshot RouteLatency::Merge(int route, Phase phase) {
+    Histogram::Snapshot out;
+    size_t index = static_cast<size_t>(route) * kPhaseNum + phase;
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (index < registry.retired.size()) {
+        out.Merge(registry.retired[index]);
+    }
+    for (Table* table : registry.tables) {
+        std::lock_guard<std::mutex> growLock(table->growMutex);
+        if (index < table->histograms.size() && table->histograms[index] != nullptr) {
+            table->histograms[index]->AddTo(out);
+        }
+    }
+    return out;
+}
+
+std::string RouteLatency::Render() {
+    constexpr std::array<double, 4> kQuantiles{0.5, 0.9, 0.99, 0.999};
+    fmt::memory_buffer out;
+    fmt::format_to(std::back_inserter(out),
+                   "# HELP webserver_request_phase_seconds Request latency by route and phase\n"
+                   "# TYPE webserver_request_phase_seconds summary\n");
+    size_t routeNum = 0;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        routeNum = registry.routes.size();
+    }
+    const auto& routes = GetRegistry().routes;
+    for (size_t r = 0; r < routeNum; ++r) {
+        for (int p = 0; p < kPhaseNum; ++p) {
+            Histogram::Snapshot snap = Merge(static_cast<int>(r), static_cast<Phase>(p));
+            if (snap.count == 0) continue;
+            std::string labels = fmt::format("route=\"{}\",phase=\"{}\"", routes[r], kPhaseNames[p]);
+            for (double q : kQuantiles) {
+                fmt::format_to(std::back_inserter(out),
+                               "webserver_request_phase_seconds{{{},quantile=\"{}\"}} {:.9f}\n",
+                               labels, q, snap.Percentile(q) / 1e9);
+            }
+            fmt::format_to(std::back_inserter(out), "webserver_request_phase_seconds_sum{{{}}} {:.9f}\n",
+                           labels, snap.sum / 1e9);
+            fmt::format_to(std::back_inserter(out), "webserver_request_phase_seconds_count{{{}}} {}\n",
+                           labels, snap.count);
+        }
+    }
+    return fmt::to_string(out);
+}
+
+std::string RouteLatency::Dump() {
+    fmt::memory_buffer out;
+    fmt::format_to(std::back_inserter(out), "{:<16} {:<10} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+                   "route", "phase", "count", "p50(ms)", "p90(ms)", "p99(ms)", "p999(ms)", "max(ms)");
+    size_t routeNum = 0;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        routeNum = registry.routes.size();
+    }
+    const auto& routes = GetRegistry().routes;
+    for (size_t r = 0; r < routeNum; ++r) {
+        for (int p = 0; p < kPhaseNum; ++p) {
+            Histogram::Snapshot snap = Merge(static_cast<int>(r), static_cast<Phase>(p));
+            if (snap.count == 0) continue;
+            fmt::format_to(std::back_inserter(out),
+                           "{:<16} {:<10} {:>10} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f}\n",
+                           routes[r], kPhaseNames[p], snap.count, snap.Percentile(0.5) / 1e6,
+                           snap.Percentile(0.9) / 1e6, snap.Percentile(0.99) / 1e6,
+                           snap.Percentile(0.999) / 1e6, snap.max / 1e6);
+        }
+    }
+    return fmt::to_string(out);
+}
@@ -29,7 +29,13 @@ const std::unordered_map<std::string, std::string> SUFFIX_TYPE = {
         {".js", "text/javascript"},
 };
 
-void HttpResponse::MakeResponse(Buffer& buf, int clientFd) {
+void HttpResponse::MakeResponse(ChainBuffer& buf, int clientFd) {
+    if (hasBody_) {
+        AddStateLine(buf);
+        AddHeader(buf);
+        buf.Append(body_);
+        return;
+    }
     std::string finalPath{srcDir_ + path_};
     LOG_DEBUG("path = {}", finalPath);
     if (stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {
@@ -50,7 +56,7 @@ void HttpResponse::MakeResponse(Buffer& buf, int clientFd) {
     AddContent(buf, clientFd);
 }
 
-void HttpResponse::AddStateLine(Buffer& buf) {
+void HttpResponse::AddStateLine(ChainBuffer& buf) {
     std::string status;
     switch (code_) {
         case 200:
@@ -72,7 +78,7 @@ void HttpResponse::AddStateLine(Buffer& buf) {
     buf.Append("HTTP/1.1 " + std::to_string(code_) + " " + status + "\r\n");
 }
 
-void HttpResponse::AddHeader(Buffer& buf) {
+void HttpResponse::AddHeader(ChainBuffer& buf) {
     LOG_DEBUG("response keep-alive: {}", isKeepAlive_);
     buf.Append("Connection: ");
     if (isKeepAlive_) {
@@ -82,6 +88,13 @@ void HttpResponse::AddHeader(Buffer& buf) {
         buf.Append("close\r\n");
     }
 
+    if (hasBody_) {
+        buf.Append("Content-Type: " + contentType_ + "\r\n");
+        buf.Append("Content-Length: " + std::to_string(body_.size()) + "\r\n");
+        buf.Append("\r\n");
+        return;
+    }
+
     // Content-Type
     // 查找后缀
     std::string::size_type idx = path_.find_last_of('.');
@@ -99,7 +112,7 @@ void HttpResponse::AddHeader(Buffer& buf) {
 }
 
 // 负责打开文件
-void HttpResponse::AddContent(Buffer& buf, int clientFd) {
+void HttpResponse::AddContent(ChainBuffer& buf, int clientFd) {
     int srcFd = open((srcDir_ + path_).data(), O_RDONLY);  // 获取文件 fd
     if (srcFd < 0) {                                       // 获取文件失败,则使用404页面
         ErrorContent(buf, "File NotFound");
@@ -108,7 +121,7 @@ void HttpResponse::AddContent(Buffer& buf, int clientFd) {
     fileFd_ = srcFd;
 }
 
-void HttpResponse::ErrorContent(Buffer& buf, std::string message) {
+void HttpResponse::ErrorContent(ChainBuffer& buf, std::string message) {
     std::string body{};
     std::string status{};
     body += "<html><title>Error</title>";
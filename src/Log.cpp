@@ -1,89 +1,618 @@
 #include "Log.h"
 
 #include <assert.h>
+#include <fcntl.h>
+#include <limits.h>  // IOV_MAX
+#include <sys/resource.h>  // setpriority
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#include "EventLoop.h"
+
+namespace {
+
+// 写完 vec 中的全部数据 (处理部分写与 EINTR), 出错返回 false
+bool WriteAll(int fd, struct iovec* vec, int cnt) {
+    while (cnt > 0) {
+        ssize_t n = writev(fd, vec, cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // 跳过已写完的段, 调整写了一半的段
+        while (cnt > 0 && static_cast<size_t>(n) >= vec->iov_len) {
+            n -= vec->iov_len;
+            ++vec;
+            --cnt;
+        }
+        if (cnt > 0) {
+            vec->iov_base = static_cast<char*>(vec->iov_base) + n;
+            vec->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+}  // namespace
 
 Log::Log() {}
 
 Log::~Log() {
     if (writeThread_ != nullptr && writeThread_->joinable()) {
-        // 1. 关闭队列 (设置 flag,禁止新写入,唤醒消费者)
-        deque_->shutdown();
-        // 2. 等待后台线程结束 (会把剩余数据pop完)
+        // 1. 通知刷盘线程退出 (退出前会把剩余数据写完)
+        {
+            std::lock_guard<std::mutex> lock(flushMutex_);
+            stop_ = true;
+        }
+        flushCv_.notify_one();
+        // 2. 等待后台线程结束
         writeThread_->join();
     }
+    isAsync_.store(false, std::memory_order_relaxed);
 
-    // 3. 最后刷一次系统缓冲并关闭文件
-    if (fp_ != nullptr) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        fflush(fp_);
-        fclose(fp_);
+    // 3. 停止压缩线程 (压缩完已排队的文件后退出)
+    if (compressThread_ != nullptr && compressThread_->joinable()) {
+        compressQueue_->shutdown();
+        compressThread_->join();
+    }
+
+    // 4. 关闭文件
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
     }
 }
 
-void Log::Init(int level, const char* path, const char* suffix, int maxQueueCapacity) {
+void Log::Init(int level, const char* path, const char* suffix, int maxQueueCapacity,
+               bool deferred) {
     isOpen_ = true;
-    level_ = level;
-    if (maxQueueCapacity > 0) {
-        isAsync_ = true;
-        // 创建阻塞队列
-        if (deque_ == nullptr) {
-            deque_ = std::make_unique<BlockQueue<std::string>>(maxQueueCapacity);
-            // 启动后台线程
-            writeThread_ = std::make_unique<std::thread>(FlushLogThread);
-        }
-    } else {
-        isAsync_ = false;
-    }
+    setLevel(level);
 
-    lineCount_ = 0;
     time_t t = time(nullptr);
-    struct tm* sysTime = localtime(&t);
-    struct tm t_now = *sysTime;
+    struct tm t_now;
+    localtime_r(&t, &t_now);
+
+    // 先写完旧文件的缓冲 (刷盘线程需要 mutex_, 不能持锁等待)
+    Flush();
+
+    std::lock_guard<std::mutex> rotateLock(rotateMutex_);
     path_ = path;
     suffix_ = suffix;
+    dayCheckSec_ = t;
 
-    // 创建日志文件名: path/YYYY_MM_DD.log
-    char fileName[LOG_NAME_LEN] = {0};
-    snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s", path_, t_now.tm_year + 1900,
-             t_now.tm_mon + 1, t_now.tm_mday, suffix_);
-    toDay_ = t_now.tm_mday;
-
+    // 日志文件名: path/YYYY_MM_DD.log, 接着当天已有的最后一个文件继续写
+    int index = LastSegment(t_now);
+    std::string fileName = SegmentName(t_now, index);
+    int fd = OpenSegment(fileName);
+    assert(fd >= 0);
+    struct stat st;
+    size_t size = fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        buffer_.RetrieveAll();
-        if (fp_ != nullptr) {
-            Flush();
-            fclose(fp_);
+        if (fd_ >= 0) {
+            close(fd_);
         }
+        fd_ = fd;
+        lineCount_ = 0;  // 已有文件的行数未知, 只按字节数续算
+        bytes_ = size;
+    }
+    toDay_ = t_now.tm_mday;
+    segment_ = index;
+    fileName_ = fileName;
 
-        fp_ = fopen(fileName, "a");
-        if (fp_ == nullptr) {
-            mkdir(path_, 0777);  // 尝试创建目录
-            fp_ = fopen(fileName, "a");
+    if (maxQueueCapacity > 0) {
+        // 已创建的缓冲区保持原大小, 新线程使用新大小
+        ringCapacity_ = static_cast<size_t>(maxQueueCapacity) * 256;
+        isAsync_.store(true, std::memory_order_relaxed);
+        // 启动后台线程 (线程启动后缓冲区里可能已有记录, 不再切换格式)
+        if (writeThread_ == nullptr) {
+            deferred_.store(deferred, std::memory_order_relaxed);
+            writeThread_ = std::make_unique<std::thread>(FlushLogThread);
         }
-        assert(fp_ != nullptr);
+    } else {
+        isAsync_.store(false, std::memory_order_relaxed);
     }
 }
 
 // 异步写线程入口
 void Log::FlushLogThread() { Log::getInstance()->AsyncWrite(); }
 
+LogRing* Log::LocalRing() {
+    // 线程退出时标记缓冲区已关闭, 刷盘线程写完剩余数据后释放
+    struct Holder {
+        std::shared_ptr<LogRing> ring;
+        ~Holder() {
+            if (ring != nullptr) ring->closed.store(true, std::memory_order_release);
+        }
+    };
+    thread_local Holder holder;
+    if (holder.ring == nullptr) {
+        holder.ring = std::make_shared<LogRing>(ringCapacity_);
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.push_back(holder.ring);
+    }
+    return holder.ring.get();
+}
+
+void Log::Append(int level, const char* data, size_t len) {
+    if (!isAsync_.load(std::memory_order_relaxed)) {
+        WriteSync(data, len);
+        return;
+    }
+    LogRing* ring = LocalRing();
+    if (PushWithPolicy(ring, level, data, len)) {
+        // 超过一半时提前唤醒刷盘线程, 每次读空前只唤醒一次
+        if (ring->Exceeds(ring->Capacity() / 2) &&
+            !ring->notified.exchange(true, std::memory_order_relaxed)) {
+            WakeFlusher();
+        }
+        return;
+    }
+    //! 丢弃: 只有本线程修改计数, 不需要原子加
+    ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+    if (!ring->notified.exchange(true, std::memory_order_relaxed)) {
+        WakeFlusher();
+    }
+}
+
+bool Log::PushWithPolicy(LogRing* ring, int level, const char* data, size_t len) {
+    switch (overflow_.load(std::memory_order_relaxed)) {
+        case OverflowPolicy::DROP_LOW_LEVEL: {
+            // 低级别日志在缓冲区还有余量时就开始丢弃, 把剩余空间留给高级别日志
+            static const size_t LIMIT_PERCENT[] = {50, 75, 90};
+            if (level >= 0 && level < 3 &&
+                ring->Exceeds(ring->Capacity() / 100 * LIMIT_PERCENT[level])) {
+                return false;
+            }
+            return ring->Push(data, len);
+        }
+        case OverflowPolicy::BLOCK_TIMEOUT: {
+            if (ring->Push(data, len)) {
+                return true;
+            }
+            //! 等待会让整个 Loop 停顿 (所有连接一起卡住): EventLoop 线程上直接丢弃, 由 Append 唤醒刷盘线程
+            if (t_loop != nullptr) {
+                return false;
+            }
+            // 只等待有限时间, 刷盘线程腾出空间后继续
+            WakeFlusher();
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::microseconds(blockTimeoutUs_.load(std::memory_order_relaxed));
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                if (ring->Push(data, len)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        case OverflowPolicy::SAMPLE:
+            if (ring->Exceeds(ring->Capacity() / 2) && ring->sampleSeq++ % sampleRate_.load(std::memory_order_relaxed) != 0) {
+                return false;
+            }
+            return ring->Push(data, len);
+        case OverflowPolicy::DROP:
+        default:
+            return ring->Push(data, len);
+    }
+}
+
+void Log::SetOverflowPolicy(OverflowPolicy policy, int blockTimeoutUs, int sampleRate) {
+    blockTimeoutUs_.store(std::max(0, blockTimeoutUs), std::memory_order_relaxed);
+    sampleRate_.store(static_cast<uint32_t>(std::max(1, sampleRate)), std::memory_order_relaxed);
+    overflow_.store(policy, std::memory_order_relaxed);
+}
+
+uint64_t Log::getDroppedCount() {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    uint64_t total = retiredDropped_;
+    for (auto& ring : rings_) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Log::ReportDropped() {
+    time_t t = time(nullptr);
+    if (t == dropReportSec_) {
+        return;  // 每秒最多报告一次
+    }
+    dropReportSec_ = t;
+    uint64_t total = getDroppedCount();
+    if (total == reportedDropped_) {
+        return;
+    }
+
+    fmt::memory_buffer line;
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    FormatPrefix(line, 2, now);
+    fmt::format_to(std::back_inserter(line), "Log overflow: dropped {} lines (total {})\n",
+                   total - reportedDropped_, total);
+    reportedDropped_ = total;
+    std::lock_guard<std::mutex> lock(mutex_);
+    struct iovec vec = {line.data(), line.size()};
+    if (fd_ >= 0 && WriteAll(fd_, &vec, 1)) {
+        Account(line.size(), 1);
+    }
+}
+
+void Log::FormatPrefix(fmt::memory_buffer& out, int level, const struct timeval& now) {
+    //* 每个线程缓存 "YYYY-MM-DD HH:MM:SS", 每秒只调用一次 localtime_r (内部有全局锁)
+    struct DateCache {
+        time_t sec{-1};
+        char text[32]{};
+        size_t len{0};
+    };
+    thread_local DateCache cache;
+    if (now.tv_sec != cache.sec) {
+        time_t tSec = now.tv_sec;
+        struct tm sysTime;
+        localtime_r(&tSec, &sysTime);
+        auto res = fmt::format_to_n(cache.text, sizeof(cache.text),
+                                    "{}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}", sysTime.tm_year + 1900,
+                                    sysTime.tm_mon + 1, sysTime.tm_mday, sysTime.tm_hour,
+                                    sysTime.tm_min, sysTime.tm_sec);
+        cache.len = std::min(res.size, sizeof(cache.text));
+        cache.sec = now.tv_sec;
+    }
+
+    //* 只补微秒: "[LEVEL] 日期.uuuuuu "
+    const char* levelStr = LevelToString(level);
+    out.push_back('[');
+    out.append(levelStr, levelStr + strlen(levelStr));
+    out.push_back(']');
+    out.push_back(' ');
+    out.append(cache.text, cache.text + cache.len);
+    char usec[8] = {'.', '0', '0', '0', '0', '0', '0', ' '};
+    for (int i = 6, v = static_cast<int>(now.tv_usec); i > 0 && v > 0; --i, v /= 10) {
+        usec[i] = static_cast<char>('0' + v % 10);
+    }
+    out.append(usec, usec + sizeof(usec));
+}
+
+void Log::FormatRecord(const char* record, fmt::memory_buffer& out) {
+    LogRecord head;
+    memcpy(&head, record, sizeof(head));
+    struct timeval now = {static_cast<time_t>(head.sec), static_cast<suseconds_t>(head.usec)};
+    FormatPrefix(out, head.level, now);
+    try {
+        head.decode(out, fmt::string_view(head.format, head.formatLen), record + sizeof(head));
+    } catch (const std::exception& e) {
+        fmt::format_to(std::back_inserter(out), "Log Format Error: {}", e.what());
+    }
+    out.push_back('\n');
+}
+
+void Log::WakeFlusher() {
+    {
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        wakeup_ = true;
+    }
+    flushCv_.notify_one();
+}
+
+void Log::WriteSync(const char* data, size_t len) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        struct iovec vec = {const_cast<char*>(data), len};
+        if (fd_ >= 0 && WriteAll(fd_, &vec, 1)) {
+            Account(len, 1);
+        }
+    }
+    // 异步模式下由刷盘线程切分
+    if (!isAsync_.load(std::memory_order_relaxed)) {
+        MaybeRotate();
+    }
+}
+
+void Log::Account(size_t bytes, size_t lines) {
+    bytes_ += bytes;
+    lineCount_ += static_cast<int>(lines);
+}
+
 // 真正的写盘逻辑(在后台线程跑)
 void Log::AsyncWrite() {
-    std::string str;
-    // 循环从队列取日志
-    while (deque_->pop(str)) {
+    while (true) {
+        uint64_t req = 0;
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(flushMutex_);
+            // 没有 Flush 请求/唤醒时每 FLUSH_INTERVAL_MS_ 收集一次
+            flushCv_.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS_),
+                              [this]() { return stop_ || wakeup_ || flushReq_ != flushDone_; });
+            wakeup_ = false;
+            stop = stop_;
+            req = flushReq_;
+        }
+
+        DrainRings();
+        ReportDropped();
+        MaybeRotate();
+
+        {
+            std::lock_guard<std::mutex> lock(flushMutex_);
+            flushDone_ = req;
+        }
+        flushDoneCv_.notify_all();
+
+        // 退出前已经把剩余数据写完
+        if (stop) {
+            break;
+        }
+    }
+}
+
+void Log::DrainRings() {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        // 回收已退出线程且已读空的缓冲区
+        std::erase_if(rings_, [this](const std::shared_ptr<LogRing>& ring) {
+            if (ring->closed.load(std::memory_order_acquire) && ring->Size() == 0) {
+                retiredDropped_ += ring->dropped.load(std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        });
+        rings = rings_;
+    }
+    if (deferred_.load(std::memory_order_relaxed)) {
+        DrainRecords(rings);
+        return;
+    }
+
+    // 每个缓冲区最多两段, 按 IOV_MAX 分批 writev
+    const size_t batch = IOV_MAX / 2;
+    std::vector<struct iovec> vec;
+    std::vector<size_t> lens;
+    for (size_t begin = 0; begin < rings.size(); begin += batch) {
+        size_t end = std::min(rings.size(), begin + batch);
+        vec.clear();
+        lens.clear();
+        for (size_t i = begin; i < end; ++i) {
+            struct iovec v[2];
+            int cnt = 0;
+            lens.push_back(rings[i]->Peek(v, &cnt));
+            vec.insert(vec.end(), v, v + cnt);
+        }
+        if (!vec.empty()) {
+            // 统计行数用于切分 (在刷盘线程上, 不影响业务线程)
+            size_t bytes = 0, lines = 0;
+            for (auto& v : vec) {
+                const char* data = static_cast<const char*>(v.iov_base);
+                bytes += v.iov_len;
+                lines += std::count(data, data + v.iov_len, '\n');
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (fd_ >= 0 && WriteAll(fd_, vec.data(), static_cast<int>(vec.size()))) {
+                Account(bytes, lines);
+            } else {
+                //! 写失败时丢弃本批数据, 避免业务线程一直写不进缓冲区
+                fprintf(stderr, "Log writev error: %s\n", strerror(errno));
+            }
+        }
+        for (size_t i = begin; i < end; ++i) {
+            rings[i]->Consume(lens[i - begin]);
+            rings[i]->notified.store(false, std::memory_order_relaxed);
+        }
+    }
+}
+
+// 延迟格式化模式: 逐条解码为文本, 所有缓冲区合并为一次写入
+void Log::DrainRecords(const std::vector<std::shared_ptr<LogRing>>& rings) {
+    flushBuffer_.clear();
+    size_t lines = 0;
+    std::vector<size_t> lens(rings.size(), 0);
+    for (size_t i = 0; i < rings.size(); ++i) {
+        // 生产者每次发布一整条记录, 所以可读数据总是由完整记录组成
+        size_t avail = rings[i]->Size();
+        size_t offset = 0;
+        while (offset + sizeof(uint32_t) <= avail) {
+            uint32_t len = 0;
+            rings[i]->CopyOut(offset, &len, sizeof(len));
+            recordBuffer_.resize(len);
+            rings[i]->CopyOut(offset, recordBuffer_.data(), len);
+            FormatRecord(recordBuffer_.data(), flushBuffer_);
+            offset += len;
+            ++lines;
+        }
+        lens[i] = offset;
+    }
+
+    if (flushBuffer_.size() > 0) {
         std::lock_guard<std::mutex> lock(mutex_);
-        fputs(str.c_str(), fp_);
-        fflush(fp_);
+        struct iovec vec = {flushBuffer_.data(), flushBuffer_.size()};
+        if (fd_ >= 0 && WriteAll(fd_, &vec, 1)) {
+            Account(flushBuffer_.size(), lines);
+        } else {
+            fprintf(stderr, "Log write error: %s\n", strerror(errno));
+        }
+    }
+    for (size_t i = 0; i < rings.size(); ++i) {
+        rings[i]->Consume(lens[i]);
+        rings[i]->notified.store(false, std::memory_order_relaxed);
+    }
+    // 突发大量日志后释放多余内存
+    if (flushBuffer_.capacity() > (1 << 22)) {
+        flushBuffer_ = fmt::memory_buffer();
     }
-    // 退出前最后刷一次
-    fflush(fp_);
 }
 
 void Log::Flush() {
-    if (isAsync_) {
-        deque_->flush();  // 唤醒后台线程去取
+    if (!isAsync_.load(std::memory_order_relaxed) || writeThread_ == nullptr) {
+        return;  // 同步模式直接写入文件, 没有缓冲
+    }
+    std::unique_lock<std::mutex> lock(flushMutex_);
+    uint64_t req = ++flushReq_;
+    flushCv_.notify_one();
+    // 等待刷盘线程完成一轮 (该轮开始于本次请求之后)
+    flushDoneCv_.wait(lock, [this, req]() { return flushDone_ >= req || stop_; });
+}
+
+void Log::SetRotate(int maxLines, size_t maxBytes, bool compress) {
+    std::lock_guard<std::mutex> lock(rotateMutex_);
+    maxLines_ = maxLines;
+    maxBytes_ = maxBytes;
+    compress_ = compress;
+}
+
+void Log::MaybeRotate() {
+    std::lock_guard<std::mutex> rotateLock(rotateMutex_);
+    if (fd_ < 0) {
+        return;  // 还没有 Init
+    }
+
+    //* 1. 跨天: 每秒最多检查一次
+    time_t t = time(nullptr);
+    struct tm t_now;
+    if (t != dayCheckSec_) {
+        dayCheckSec_ = t;
+        localtime_r(&t, &t_now);
+        if (t_now.tm_mday != toDay_) {
+            Rotate(t_now, LastSegment(t_now));
+            return;
+        }
+    }
+
+    //* 2. 行数/字节数超限
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full = (maxLines_ > 0 && lineCount_ >= maxLines_) || (maxBytes_ > 0 && bytes_ >= maxBytes_);
+    }
+    if (full) {
+        localtime_r(&t, &t_now);
+        // 时钟回拨到前一天时不会越过 toDay_ 的序号, 仍按当前文件继续编号
+        Rotate(t_now, t_now.tm_mday == toDay_ ? segment_ + 1 : LastSegment(t_now) + 1);
     }
-    fflush(fp_);  // 强制刷入磁盘
+}
+
+void Log::Rotate(const struct tm& day, int index) {
+    std::string fileName = SegmentName(day, index);
+    int fd = OpenSegment(fileName);
+    if (fd < 0) {
+        fprintf(stderr, "Log open %s error: %s\n", fileName.c_str(), strerror(errno));
+        return;  // 继续写旧文件
+    }
+
+    // 新文件已打开, 只在替换 fd 时持锁
+    int oldFd = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        oldFd = fd_;
+        fd_ = fd;
+        lineCount_ = 0;
+        bytes_ = 0;
+    }
+    close(oldFd);
+
+    std::string oldName = std::move(fileName_);
+    fileName_ = std::move(fileName);
+    toDay_ = day.tm_mday;
+    segment_ = index;
+
+    // 续写同一个文件 (例如跨天后当天文件已存在) 时不压缩
+    if (!compress_ || oldName == fileName_) {
+        return;
+    }
+    if (compressThread_ == nullptr) {
+        compressQueue_ = std::make_unique<MpmcQueue<std::string>>(1024);
+        compressThread_ = std::make_unique<std::thread>(CompressThread);
+    }
+    compressQueue_->push_back(std::move(oldName));
+}
+
+std::string Log::SegmentName(const struct tm& day, int index) const {
+    char fileName[LOG_NAME_LEN] = {0};
+    if (index == 0) {
+        snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s", path_, day.tm_year + 1900,
+                 day.tm_mon + 1, day.tm_mday, suffix_);
+    } else {
+        snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d-%d%s", path_, day.tm_year + 1900,
+                 day.tm_mon + 1, day.tm_mday, index, suffix_);
+    }
+    return fileName;
+}
+
+int Log::LastSegment(const struct tm& day) const {
+    auto exists = [](const std::string& name) { return access(name.c_str(), F_OK) == 0; };
+    int index = 0;
+    while (exists(SegmentName(day, index + 1)) || exists(SegmentName(day, index + 1) + ".gz")) {
+        ++index;
+    }
+    // 最后一个文件已经压缩, 不能再追加
+    std::string last = SegmentName(day, index);
+    if (!exists(last) && exists(last + ".gz")) {
+        ++index;
+    }
+    return index;
+}
+
+int Log::OpenSegment(const std::string& name) {
+    const int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+    int fd = open(name.c_str(), flags, 0644);
+    if (fd < 0) {
+        mkdir(path_, 0777);  // 尝试创建目录
+        fd = open(name.c_str(), flags, 0644);
+    }
+    return fd;
+}
+
+// 压缩线程入口
+void Log::CompressThread() { Log::getInstance()->CompressLoop(); }
+
+void Log::CompressLoop() {
+    //* 最低 CPU 优先级 + IO 空闲调度类, 只在磁盘空闲时压缩, 不和业务线程抢资源
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+    const int IOPRIO_WHO_PROCESS = 1, IOPRIO_CLASS_IDLE = 3, IOPRIO_CLASS_SHIFT = 13;
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+
+    std::string name;
+    while (compressQueue_->pop(name)) {
+        if (!CompressFile(name)) {
+            fprintf(stderr, "Log compress %s failed\n", name.c_str());
+        }
+    }
+}
+
+// name -> name.gz, 成功后删除原文件
+bool Log::CompressFile(const std::string& name) {
+    int in = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    std::string gzName = name + ".gz";
+    gzFile out = gzopen(gzName.c_str(), "wb6");
+    if (out == nullptr) {
+        close(in);
+        return false;
+    }
+
+    bool ok = true;
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t n = read(in, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+        if (gzwrite(out, buf, static_cast<unsigned>(n)) != n) {
+            ok = false;
+            break;
+        }
+    }
+    close(in);
+    ok = gzclose(out) == Z_OK && ok;
+
+    unlink(ok ? name.c_str() : gzName.c_str());
+    return ok;
 }
@@ -0,0 +1,218 @@
+#include "Metrics.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// 一个线程的计数块, 按缓存行对齐, 只有所属线程写
+struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, Metrics::kCounterNum> values{};
+};
+
+struct Registered {
+    std::string family;
+    std::string help;
+    Metrics::Type type;
+    std::string labels;
+    std::function<int64_t()> read;
+};
+
+struct RegisteredHistogram {
+    std::string family;
+    std::string help;
+    std::vector<double> bounds;
+    std::function<Metrics::HistogramSample()> read;
+};
+
+// 所有计数块和注册的指标, 故意不析构, 避免进程退出时与线程退出的析构顺序问题
+struct Registry {
+    std::mutex mutex;
+    std::vector<Shard*> shards;
+    std::array<uint64_t, Metrics::kCounterNum> retired{};  // 已退出线程的累计值
+    std::deque<Registered> registered;  // 只增不删, deque 追加时已有元素的地址不变
+    std::deque<RegisteredHistogram> histograms;
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+thread_local Shard* t_shard = nullptr;
+
+// 线程退出时把计数并入累计值并注销
+struct ShardHolder {
+    Shard* shard{nullptr};
+    ~ShardHolder() {
+        if (shard == nullptr) return;
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (int i = 0; i < Metrics::kCounterNum; ++i) {
+            registry.retired[i] += shard->values[i].load(std::memory_order_relaxed);
+        }
+        std::erase(registry.shards, shard);
+        delete shard;
+        t_shard = nullptr;
+    }
+};
+
+Shard* RegisterShard() {
+    thread_local ShardHolder holder;
+    auto* shard = new Shard;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.shards.push_back(shard);
+    }
+    holder.shard = shard;
+    t_shard = shard;
+    return shard;
+}
+
+struct CounterInfo {
+    const char* family;
+    const char* help;
+    const char* labels;
+};
+
+// 与 Metrics::Counter 一一对应
+constexpr std::array<CounterInfo, Metrics::kCounterNum> kCounterInfo{{
+        {"webserver_accepted_connections_total", "Connections accepted by the acceptor", ""},
+        {"webserver_requests_total", "HTTP requests handled", ""},
+        {"webserver_responses_total", "HTTP responses by status class", "code=\"2xx\""},
+        {"webserver_responses_total", "HTTP responses by status class", "code=\"3xx\""},
+        {"webserver_responses_total", "HTTP responses by status class", "code=\"4xx\""},
+        {"webserver_responses_total", "HTTP responses by status class", "code=\"5xx\""},
+        {"webserver_sent_bytes_total", "Bytes sent by syscall", "via=\"writev\""},
+        {"webserver_sent_bytes_total", "Bytes sent by syscall", "via=\"sendfile\""},
+        {"webserver_db_pool_waits_total", "Waits for a MySQL connection", ""},
+        {"webserver_db_pool_wait_seconds_total", "Time spent waiting for a MySQL connection", ""},
+}};
+
+// 输出一行样本; family 与上一行不同时先输出 HELP/TYPE
+void AppendSample(fmt::memory_buffer& out, std::string& lastFamily, const std::string& family,
+                  const std::string& help, const char* type, const std::string& labels,
+                  const std::string& value) {
+    if (family != lastFamily) {
+        fmt::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", family, help,
+                       family, type);
+        lastFamily = family;
+    }
+    if (labels.empty()) {
+        fmt::format_to(std::back_inserter(out), "{} {}\n", family, value);
+    } else {
+        fmt::format_to(std::back_inserter(out), "{}{{{}}} {}\n", family, labels, value);
+    }
+}
+
+}  // namespace
+
+void Metrics::Add(Counter counter, uint64_t n) {
+    Shard* shard = t_shard != nullptr ? t_shard : RegisterShard();
+    auto& value = shard->values[counter];
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void Metrics::CountResponse(int code) {
+    Add(kRequests);
+    if (code >= 200 && code < 600) {
+        Add(static_cast<Counter>(kStatus2xx + code / 100 - 2));
+    }
+}
+
+void Metrics::Register(const std::string& family, const std::string& help, Type type,
+                       const std::string& labels, std::function<int64_t()> read) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.registered.push_back({family, help, type, labels, std::move(read)});
+}
+
+void Metrics::RegisterHistogram(const std::string& family, const std::string& help,
+                                std::vector<double> bounds,
+                                std::function<HistogramSample()> read) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.histograms.push_back({family, help, std::move(bounds), std::move(read)});
+}
+
+uint64_t Metrics::Get(Counter counter) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t total = registry.retired[counter];
+    for (Shard* shard : registry.shards) {
+        total += shard->values[counter].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::string Metrics::Render() {
+    std::array<uint64_t, kCounterNum> totals{};
+    std::vector<std::pair<const Registered*, int64_t>> samples;
+    std::vector<const RegisteredHistogram*> histograms;
+    Registry& registry = GetRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        totals = registry.retired;
+        for (Shard* shard : registry.shards) {
+            for (int i = 0; i < kCounterNum; ++i) {
+                totals[i] += shard->values[i].load(std::memory_order_relaxed);
+            }
+        }
+        // 元素地址稳定, 读取函数可以在锁外调用
+        samples.reserve(registry.registered.size());
+        for (const Registered& item : registry.registered) {
+            samples.emplace_back(&item, 0);
+        }
+        for (const RegisteredHistogram& item : registry.histograms) {
+            histograms.push_back(&item);
+        }
+    }
+    for (auto& sample : samples) {
+        sample.second = sample.first->read();
+    }
+    // 同名指标必须连续输出 (只能有一组 HELP/TYPE): 按指标名首次注册的顺序稳定排序
+    std::unordered_map<std::string, size_t> rank;
+    for (const auto& sample : samples) {
+        rank.emplace(sample.first->family, rank.size());
+    }
+    std::stable_sort(samples.begin(), samples.end(), [&rank](const auto& a, const auto& b) {
+        return rank[a.first->family] < rank[b.first->family];
+    });
+
+    fmt::memory_buffer out;
+    std::string lastFamily;
+    for (int i = 0; i < kCounterNum; ++i) {
+        const CounterInfo& info = kCounterInfo[i];
+        std::string value = i == kDbWaitNs ? fmt::format("{:.6f}", totals[i] / 1e9)
+                                           : fmt::format("{}", totals[i]);
+        AppendSample(out, lastFamily, info.family, info.help, "counter", info.labels, value);
+    }
+    for (const auto& [item, value] : samples) {
+        AppendSample(out, lastFamily, item->family, item->help,
+                     item->type == Type::Counter ? "counter" : "gauge", item->labels,
+                     fmt::format("{}", value));
+    }
+    //* 直方图: 桶计数按 Prometheus 约定累计输出
+    for (const RegisteredHistogram* item : histograms) {
+        HistogramSample sample = item->read();
+        fmt::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} histogram\n",
+                       item->family, item->help, item->family);
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < sample.counts.size(); ++i) {
+            cumulative += sample.counts[i];
+            std::string le = i < item->bounds.size() ? fmt::format("{}", item->bounds[i]) : "+Inf";
+            fmt::format_to(std::back_inserter(out), "{}_bucket{{le=\"{}\"}} {}\n", item->family,
+                           le, cumulative);
+        }
+        fmt::format_to(std::back_inserter(out), "{}_sum {:.6f}\n{}_count {}\n", item->family,
+                       sample.sum, item->family, cumulative);
+    }
+    return fmt::to_string(out);
+}
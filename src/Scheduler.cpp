@@ -0,0 +1,46 @@
+#include "Scheduler.h"
+
+void Scheduler::SetLoops(std::vector<EventLoop*> loops) {
+    loops_ = std::move(loops);
+    loopNum_.store(loops_.size(), std::memory_order_release);
+}
+
+void Scheduler::Reset() {
+    loopNum_.store(0, std::memory_order_release);
+    loops_.clear();
+}
+
+bool Scheduler::Steal(EventLoop* thief, StealableJob*& job) {
+    if (!HasPending()) {
+        return false;
+    }
+    // 每个 thief 从不同位置开始轮询, 避免所有空闲 Worker 挤在同一个 victim 上
+    thread_local size_t start = 0;
+    const size_t n = loopNum_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+        EventLoop* victim = loops_[(start + i) % n];
+        if (victim != thief && victim->StealJob(job)) {
+            start = (start + i + 1) % n;
+            JobTaken();
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::JobPosted(EventLoop* owner) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    // 投递者正忙于执行当前协程, 叫醒一个睡眠中的 Worker 来窃取;
+    // 起点轮转, 不总是叫醒编号最小的那个
+    const size_t n = loopNum_.load(std::memory_order_acquire);
+    if (n == 0) return;
+    const size_t start = wakeCursor_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i) {
+        EventLoop* loop = loops_[(start + i) % n];
+        if (loop != owner && loop->IsSleeping()) {
+            loop->WakeUp();
+            break;
+        }
+    }
+}
@@ -29,7 +29,7 @@ void Socket::Listen() {
         LOG_ERROR("Listen error: {}", std::string(strerror(errno)));
 }
 
-Socket Socket::Accept() {
+Socket Socket::Accept(sockaddr_in* peer) {
     sockaddr_in addr{};
     socklen_t len = sizeof(addr);
     int client_fd = accept(fd_, (sockaddr*)&addr, &len);
@@ -38,6 +38,9 @@ Socket Socket::Accept() {
         LOG_ERROR("Accept:invalid client_fd");
         return Socket(-1);
     }
+    if (peer != nullptr) {
+        *peer = addr;
+    }
     return Socket(client_fd);
 }
 
@@ -1,63 +1,473 @@
 #include "SqlConnPool.h"
 
+#include <algorithm>
 #include <iostream>
 
+#include "BlockingPool.h"
 #include "Log.h"
+#include "Metrics.h"
 
 void SqlConnPool::Init(const char* host, int port, const char* user, const char* pwd,
-                       const char* dbName, int connSize) {
+                       const char* dbName, int connSize, int shardNum) {
     if (connSize <= 0) {
         throw std::runtime_error("ConnSize must > 0");
     }
     MAX_CONN_ = connSize;
-    sem_ = std::make_unique<std::counting_semaphore<1000>>(connSize);
+    minConn_ = connSize;
+    host_ = host;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    port_ = port;
+    if (shardNum > 0) {
+        // 每个分片预留两倍槽位,连接被其他线程归还时也能放下
+        int perShard = (connSize + shardNum - 1) / shardNum;
+        for (int i = 0; i < shardNum; ++i) {
+            shards_.push_back(std::make_unique<Shard>(perShard * 2));
+        }
+    }
+    int count = 0;
+    const int64_t now = NowMs();
     for (int i = 0; i < connSize; ++i) {
-        MYSQL* sql = nullptr;
-        sql = mysql_init(sql);
+        MYSQL* sql = Connect();
         if (sql == nullptr) {
-            LOG_ERROR("Mysql Init Error: {}", std::string(strerror(errno)));
+            continue;  //! 连接失败不入池,由维护线程补齐
         }
-        sql = mysql_real_connect(sql, host, user, pwd, dbName, port, nullptr, 0);
-        if (sql == nullptr) {
-            LOG_ERROR("Mysql Connect Error: {}", std::string(strerror(errno)));
+        if (!shards_.empty()) {
+            // 轮流放入各分片
+            Slot& slot = shards_[count % shards_.size()]->slots[count / shards_.size()];
+            slot.since.store(now);
+            slot.conn.store(sql);
+        } else {
+            connQue_.push_back({sql, now});
         }
-        connQue_.push(sql);
+        ++count;
+    }
+    if (count < connSize) {
+        LOG_ERROR("SqlConnPool only {}/{} connections established", count, connSize);
     }
 }
 
-MYSQL* SqlConnPool::GetConn() {
-    MYSQL* sql = nullptr;
-    if (connQue_.empty()) {
-        LOG_WARN("SqlConnPool Busy!");
+MYSQL* SqlConnPool::Connect() {
+    MYSQL* sql = mysql_init(nullptr);
+    if (sql == nullptr) {
+        LOG_ERROR("Mysql Init Error: {}", std::string(strerror(errno)));
         return nullptr;
     }
+    if (mysql_real_connect(sql, host_.c_str(), user_.c_str(), pwd_.c_str(), dbName_.c_str(),
+                           port_, nullptr, 0) == nullptr) {
+        LOG_ERROR("Mysql Connect Error: {}", mysql_error(sql));
+        mysql_close(sql);
+        return nullptr;
+    }
+    connNum_.fetch_add(1);
+    return sql;
+}
 
-    // P操作: 请求资源,计数减一,如果为0则阻塞
-    sem_->acquire();
-
+void SqlConnPool::CloseConn(MYSQL* sql) {
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        sql = connQue_.front();
-        connQue_.pop();
+        // 语句必须在连接关闭前释放
+        std::unique_lock<std::shared_mutex> lock(stmtMutex_);
+        stmtCaches_.erase(sql);
+    }
+    mysql_close(sql);
+    connNum_.fetch_sub(1);
+}
+
+int SqlConnPool::ShardIndex() const {
+    int id = (t_loop != nullptr) ? t_loop->GetId() : -1;
+    if (id < 0) {
+        // 非 Worker 线程按线程 id 散列到某个分片
+        id = static_cast<int>(std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0x7fffffff);
+    }
+    return id % static_cast<int>(shards_.size());
+}
+
+MYSQL* SqlConnPool::TakeFromShards() {
+    const int n = static_cast<int>(shards_.size());
+    const int self = ShardIndex();
+    for (int k = 0; k < n; ++k) {
+        Shard& shard = *shards_[(self + k) % n];
+        for (auto& slot : shard.slots) {
+            if (slot.conn.load() == nullptr) continue;
+            MYSQL* sql = slot.conn.exchange(nullptr);
+            if (sql != nullptr) {
+                if (k > 0) steals_.fetch_add(1, std::memory_order_relaxed);
+                return sql;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool SqlConnPool::PutToShards(MYSQL* sql, int64_t since) {
+    const int n = static_cast<int>(shards_.size());
+    const int self = ShardIndex();
+    for (int k = 0; k < n; ++k) {
+        Shard& shard = *shards_[(self + k) % n];
+        for (auto& slot : shard.slots) {
+            MYSQL* expected = nullptr;
+            if (slot.conn.load() != nullptr) continue;
+            // since 先于 conn 发布; CAS 失败时会覆盖别的连接的 since,只会让它显得更"新",无害
+            slot.since.store(since, std::memory_order_relaxed);
+            if (slot.conn.compare_exchange_strong(expected, sql)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+MYSQL* SqlConnPool::TakeIdle() {
+    MYSQL* sql = shards_.empty() ? nullptr : TakeFromShards();
+    if (sql == nullptr && !connQue_.empty()) {
+        sql = connQue_.back().sql;
+        connQue_.pop_back();
     }
     return sql;
 }
 
+void SqlConnPool::PutIdle(MYSQL* sql, int64_t since) {
+    if (shards_.empty() || !PutToShards(sql, since)) {
+        connQue_.push_back({sql, since});
+    }
+}
+
+MYSQL* SqlConnPool::TryGetConn() {
+    //* 分片模式快速路径: 只动本线程分片的原子槽位,不加锁
+    if (!shards_.empty()) {
+        if (MYSQL* sql = TakeFromShards(); sql != nullptr) {
+            return sql;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return TakeIdle();
+}
+
+MYSQL* SqlConnPool::GetConn() {
+    auto start = Clock::now();
+    auto waiter = std::make_shared<Waiter>();
+    waiter->sem = std::make_unique<std::binary_semaphore>(0);
+    if (!Park(waiter)) {
+        RecordWait(Clock::now() - start, false);
+        return waiter->conn;
+    }
+
+    LOG_WARN("SqlConnPool Busy!");
+    // 在队列中等待 FreeConn 移交连接
+    waiter->sem->acquire();
+    RecordWait(Clock::now() - start, false);
+    return waiter->conn;
+}
+
+bool SqlConnPool::Park(const std::shared_ptr<Waiter>& waiter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    //! 先登记等待者再扫描空闲连接,与 FreeConn "先放回再检查等待者" 配对,
+    //! 保证两边至少有一方看到对方,不会出现连接闲置而等待者一直挂起
+    waiterNum_.fetch_add(1);
+    if (MYSQL* sql = TakeIdle(); sql != nullptr) {
+        waiterNum_.fetch_sub(1);
+        waiter->conn = sql;
+        return false;
+    }
+    waiters_.push_back(waiter);
+    if (healthThread_ != nullptr && connNum_.load() < MAX_CONN_) {
+        // 通知维护线程扩容
+        std::lock_guard<std::mutex> healthLock(healthMutex_);
+        growRequested_ = true;
+        healthCv_.notify_one();
+    }
+    return true;
+}
+
+bool SqlConnPool::CancelWait(const std::shared_ptr<Waiter>& waiter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = waiters_.begin(); it != waiters_.end(); ++it) {
+        if (*it == waiter) {
+            waiters_.erase(it);
+            waiterNum_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;  // 已被 FreeConn 移交,恢复任务已经投递
+}
+
+void SqlConnPool::Wake(const std::shared_ptr<Waiter>& waiter) {
+    if (waiter->sem != nullptr) {
+        waiter->sem->release();
+        return;
+    }
+    // 回到等待者所属的 EventLoop 恢复协程,保证协程始终在同一线程执行
+    waiter->loop->RunInLoop([waiter]() {
+        if (waiter->timerId != 0) {
+            waiter->loop->DelTimer(waiter->timerId);
+        }
+        waiter->handle.resume();
+    });
+}
+
+// 在 BlockingPool 的辅助线程上重连断线的连接
+struct SqlConnPool::ReconnectJob : BlockingPool::Job {
+    SqlConnPool* pool;
+    MYSQL* sql;
+
+    ReconnectJob(SqlConnPool* p, MYSQL* s) : pool(p), sql(s) { run = &ReconnectJob::Run; }
+
+    static void Run(BlockingPool::Job* job) {
+        auto* self = static_cast<ReconnectJob*>(job);
+        self->pool->Reconnect(self->sql);
+        delete self;
+    }
+};
+
 void SqlConnPool::FreeConn(MYSQL* sql) {
     if (sql == nullptr) return;
+    //! 断线的连接不能再交给别人: 有维护线程时交给它重连, 否则在 Loop 线程上交给 BlockingPool,
+    //! 不在 Loop 线程时才就地重连 (mysql_real_connect 会阻塞)
+    unsigned int err = mysql_errno(sql);
+    if (err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST) {
+        LOG_WARN("Mysql connection lost ({}), reconnecting", err);
+        if (healthThread_ != nullptr) {
+            std::lock_guard<std::mutex> lock(healthMutex_);
+            broken_.push_back(sql);
+            healthCv_.notify_one();
+            return;
+        }
+        if (t_loop != nullptr) {
+            auto* job = new ReconnectJob(this, sql);
+            if (!BlockingPool::getInstance()->Submit(job)) {
+                delete job;
+                CloseConn(sql);  // 不能阻塞 Loop: 放弃这条连接
+                LOG_ERROR("BlockingPool unavailable, dropped broken connection, {} left",
+                          connNum_.load());
+            }
+            return;
+        }
+        Reconnect(sql);
+        return;
+    }
+    Release(sql, NowMs());
+}
+
+void SqlConnPool::Reconnect(MYSQL* sql) {
+    CloseConn(sql);
+    MYSQL* fresh = Connect();
+    if (fresh == nullptr) return;
+    reconnects_.fetch_add(1, std::memory_order_relaxed);
+    Release(fresh, NowMs());
+}
+
+void SqlConnPool::Release(MYSQL* sql, int64_t since) {
+    //* 分片模式快速路径: 没有等待者时直接放回分片,不加锁
+    if (!shards_.empty() && waiterNum_.load() == 0 && PutToShards(sql, since)) {
+        if (waiterNum_.load() == 0) return;
+        sql = nullptr;  // 放回期间有人开始排队,下面替它从分片取回连接
+    }
+
+    std::vector<std::shared_ptr<Waiter>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!waiters_.empty()) {
+            MYSQL* conn = (sql != nullptr) ? sql : TakeIdle();
+            sql = nullptr;
+            if (conn == nullptr) break;
+            auto waiter = std::move(waiters_.front());
+            waiters_.pop_front();
+            waiterNum_.fetch_sub(1);
+            waiter->conn = conn;
+            ready.push_back(std::move(waiter));
+        }
+        if (sql != nullptr) {
+            PutIdle(sql, since);
+        }
+    }
+    for (auto& waiter : ready) {
+        Wake(waiter);
+    }
+}
+
+int SqlConnPool::getFreeConnCount() {
     std::lock_guard<std::mutex> lock(mutex_);
-    connQue_.push(sql);
+    int count = static_cast<int>(connQue_.size());
+    for (auto& shard : shards_) {
+        for (auto& slot : shard->slots) {
+            if (slot.conn.load(std::memory_order_relaxed) != nullptr) ++count;
+        }
+    }
+    return count;
+}
+
+void SqlConnPool::RecordWait(std::chrono::nanoseconds wait, bool timeout) {
+    if (timeout) {
+        waitTimeouts_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Metrics::Add(Metrics::kDbWaits);
+    Metrics::Add(Metrics::kDbWaitNs, static_cast<uint64_t>(wait.count()));
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+    int bucket = 0;
+    while (bucket < kWaitBuckets - 1 && us >= (1LL << bucket)) {
+        ++bucket;
+    }
+    waitBuckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> SqlConnPool::getWaitHistogram() const {
+    std::vector<uint64_t> hist(kWaitBuckets);
+    for (int i = 0; i < kWaitBuckets; ++i) {
+        hist[i] = waitBuckets_[i].load(std::memory_order_relaxed);
+    }
+    return hist;
+}
+
+SqlStmtCache* SqlConnPool::GetStmtCache(MYSQL* sql) {
+    {
+        std::shared_lock<std::shared_mutex> lock(stmtMutex_);
+        if (auto it = stmtCaches_.find(sql); it != stmtCaches_.end()) {
+            return it->second.get();
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(stmtMutex_);
+    auto& cache = stmtCaches_[sql];
+    if (cache == nullptr) {
+        cache = std::make_unique<SqlStmtCache>(sql);
+    }
+    return cache.get();
+}
 
-    // V操作: 释放资源,计数加1,唤醒等待者
-    sem_->release();
+void SqlConnPool::StartHealthCheck(int minConn, int maxConn, int checkIntervalMs,
+                                   int idleTimeoutMs) {
+    if (minConn < 0 || maxConn < std::max(minConn, 1)) {
+        throw std::runtime_error("SqlConnPool: require 0 <= minConn <= maxConn, maxConn > 0");
+    }
+    if (healthThread_ != nullptr) return;
+    minConn_ = minConn;
+    MAX_CONN_ = maxConn;
+    checkIntervalMs_ = checkIntervalMs;
+    idleTimeoutMs_ = idleTimeoutMs;
+    healthThread_ = std::make_unique<std::thread>([this]() { HealthCheckLoop(); });
+}
+
+bool SqlConnPool::TakeStale(int64_t minIdleMs, const std::unordered_set<MYSQL*>& checked,
+                            IdleConn& out) {
+    const int64_t now = NowMs();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = connQue_.begin(); it != connQue_.end(); ++it) {
+            if (now - it->since >= minIdleMs && !checked.contains(it->sql)) {
+                out = *it;
+                connQue_.erase(it);
+                return true;
+            }
+        }
+    }
+    //! 先取走连接再读 since: 槽位可能在读 since 之后被换成另一条连接,
+    //! 先读会把新连接按旧连接的空闲时间处理. 不符合条件的放回去
+    for (auto& shard : shards_) {
+        for (auto& slot : shard->slots) {
+            MYSQL* cur = slot.conn.load();
+            if (cur == nullptr || checked.contains(cur)) continue;
+            MYSQL* sql = slot.conn.exchange(nullptr);
+            if (sql == nullptr) continue;
+            int64_t since = slot.since.load(std::memory_order_relaxed);
+            if (now - since < minIdleMs || checked.contains(sql)) {
+                Release(sql, since);
+                continue;
+            }
+            out = {sql, since};
+            return true;
+        }
+    }
+    return false;
+}
+
+void SqlConnPool::HealthCheckLoop() {
+    int64_t nextCheck = NowMs() + checkIntervalMs_;
+    std::unique_lock<std::mutex> lock(healthMutex_);
+    while (!healthStop_) {
+        healthCv_.wait_for(lock, std::chrono::milliseconds(checkIntervalMs_), [this]() {
+            return healthStop_ || growRequested_ || !broken_.empty();
+        });
+        if (healthStop_) break;
+        std::vector<MYSQL*> broken;
+        broken.swap(broken_);
+        growRequested_ = false;
+        lock.unlock();
+
+        //* 1. 重连断线的连接
+        for (MYSQL* sql : broken) {
+            Reconnect(sql);
+        }
+
+        //* 2. 弹性扩容: 补齐最小连接数; 有协程排队且未到上限时继续加
+        while (connNum_.load() < minConn_ ||
+               (waiterNum_.load() > 0 && connNum_.load() < MAX_CONN_)) {
+            MYSQL* sql = Connect();
+            if (sql == nullptr) break;  // 数据库不可用,等下一轮
+            LOG_INFO("SqlConnPool grow to {} connections", connNum_.load());
+            Release(sql, NowMs());
+        }
+
+        //* 3. 定期检查空闲连接: 回收空闲过久的, ping 其余的
+        if (int64_t now = NowMs(); now >= nextCheck) {
+            nextCheck = now + checkIntervalMs_;
+            //! 一次只取出一条: ping 可能阻塞到连接超时, 期间其余空闲连接仍可被获取,
+            //! 不会让连接池看起来是空的 (等待者超时、无谓扩容)
+            std::unordered_set<MYSQL*> checked;
+            IdleConn idle{};
+            while (TakeStale(checkIntervalMs_, checked, idle)) {
+                if (now - idle.since >= idleTimeoutMs_ && connNum_.load() > minConn_) {
+                    CloseConn(idle.sql);
+                    LOG_INFO("SqlConnPool trim idle connection, {} left", connNum_.load());
+                    continue;
+                }
+                if (mysql_ping(idle.sql) != 0) {
+                    LOG_WARN("Mysql ping failed: {}, reconnecting", mysql_error(idle.sql));
+                    Reconnect(idle.sql);
+                    continue;
+                }
+                checked.insert(idle.sql);
+                Release(idle.sql, idle.since);  // ping 不算使用,保留空闲起点
+            }
+        }
+        lock.lock();
+    }
 }
 
 void SqlConnPool::ClosePool() {
+    if (closed_.exchange(true)) {
+        return;
+    }
+    if (healthThread_ != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(healthMutex_);
+            healthStop_ = true;
+        }
+        healthCv_.notify_one();
+        if (healthThread_->joinable()) healthThread_->join();
+        healthThread_.reset();
+        for (MYSQL* sql : broken_) {
+            CloseConn(sql);
+        }
+        broken_.clear();
+    }
+    {
+        // 语句必须在连接关闭前释放
+        std::unique_lock<std::shared_mutex> lock(stmtMutex_);
+        stmtCaches_.clear();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
-    while (!connQue_.empty()) {
-        auto conn = connQue_.front();
-        connQue_.pop();
-        mysql_close(conn);
+    for (auto& shard : shards_) {
+        for (auto& slot : shard->slots) {
+            if (MYSQL* conn = slot.conn.exchange(nullptr); conn != nullptr) {
+                mysql_close(conn);
+                connNum_.fetch_sub(1);
+            }
+        }
+    }
+    for (auto& idle : connQue_) {
+        mysql_close(idle.sql);
+        connNum_.fetch_sub(1);
     }
+    connQue_.clear();
     mysql_library_end();
-}
\ No newline at end of file
+}
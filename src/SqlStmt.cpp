@@ -0,0 +1,152 @@
+#include "SqlStmt.h"
+
+#include <cstring>
+
+#include "Log.h"
+
+SqlStmt::SqlStmt(MYSQL_STMT* stmt)
+    : stmt_(stmt),
+      params_(mysql_stmt_param_count(stmt)),
+      paramValues_(params_.size()),
+      results_(mysql_stmt_field_count(stmt)) {
+    // MYSQL_BIND 必须清零,未用到的字段才有正确的默认值
+    std::memset(params_.data(), 0, params_.size() * sizeof(MYSQL_BIND));
+    std::memset(results_.data(), 0, results_.size() * sizeof(MYSQL_BIND));
+}
+
+SqlStmt::~SqlStmt() {
+    if (stmt_ != nullptr) {
+        mysql_stmt_close(stmt_);
+    }
+}
+
+void SqlStmt::BindParam(int idx, std::string_view value) {
+    MYSQL_BIND& bind = params_.at(idx);
+    ParamValue& val = paramValues_[idx];
+    val.len = value.size();
+    val.isNull = false;
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char*>(value.data());
+    bind.buffer_length = value.size();
+    bind.length = &val.len;
+    bind.is_null = &val.isNull;
+}
+
+void SqlStmt::BindParam(int idx, int64_t value) {
+    MYSQL_BIND& bind = params_.at(idx);
+    ParamValue& val = paramValues_[idx];
+    val.i = value;
+    val.isNull = false;
+    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+    bind.buffer = &val.i;
+    bind.length = nullptr;
+    bind.is_null = &val.isNull;
+}
+
+void SqlStmt::BindParam(int idx, double value) {
+    MYSQL_BIND& bind = params_.at(idx);
+    ParamValue& val = paramValues_[idx];
+    val.d = value;
+    val.isNull = false;
+    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+    bind.buffer = &val.d;
+    bind.length = nullptr;
+    bind.is_null = &val.isNull;
+}
+
+void SqlStmt::BindParamNull(int idx) {
+    MYSQL_BIND& bind = params_.at(idx);
+    ParamValue& val = paramValues_[idx];
+    val.isNull = true;
+    bind.buffer_type = MYSQL_TYPE_NULL;
+    bind.buffer = nullptr;
+    bind.is_null = &val.isNull;
+}
+
+void SqlStmt::BindResult(int idx, char* buf, size_t cap, unsigned long* len, bool* isNull) {
+    MYSQL_BIND& bind = results_.at(idx);
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = buf;
+    bind.buffer_length = cap;
+    bind.length = len;
+    bind.is_null = isNull;
+}
+
+void SqlStmt::BindResult(int idx, int64_t* value, bool* isNull) {
+    MYSQL_BIND& bind = results_.at(idx);
+    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+    bind.buffer = value;
+    bind.is_null = isNull;
+}
+
+void SqlStmt::BindResult(int idx, double* value, bool* isNull) {
+    MYSQL_BIND& bind = results_.at(idx);
+    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+    bind.buffer = value;
+    bind.is_null = isNull;
+}
+
+bool SqlStmt::Execute() {
+    mysql_stmt_free_result(stmt_);  // 释放上一次执行留下的结果集
+    if (!params_.empty() && mysql_stmt_bind_param(stmt_, params_.data())) {
+        LOG_ERROR("mysql_stmt_bind_param error: {}", Error());
+        return false;
+    }
+    if (mysql_stmt_execute(stmt_) != 0) {
+        LOG_ERROR("mysql_stmt_execute error: {}", Error());
+        return false;
+    }
+    if (!results_.empty()) {
+        if (mysql_stmt_bind_result(stmt_, results_.data())) {
+            LOG_ERROR("mysql_stmt_bind_result error: {}", Error());
+            return false;
+        }
+        if (mysql_stmt_store_result(stmt_) != 0) {
+            LOG_ERROR("mysql_stmt_store_result error: {}", Error());
+            return false;
+        }
+    }
+    return true;
+}
+
+int SqlStmt::Fetch() {
+    int ret = mysql_stmt_fetch(stmt_);
+    if (ret == 0 || ret == MYSQL_DATA_TRUNCATED) {
+        return 1;  // 截断时 *len 大于缓冲区容量,由调用方判断
+    }
+    if (ret == MYSQL_NO_DATA) {
+        return 0;
+    }
+    LOG_ERROR("mysql_stmt_fetch error: {}", Error());
+    return -1;
+}
+
+SqlStmt* SqlStmtCache::Get(const std::string& query) {
+    if (auto it = stmts_.find(query); it != stmts_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+        return it->second.stmt.get();
+    }
+
+    MYSQL_STMT* stmt = mysql_stmt_init(sql_);
+    if (stmt == nullptr) {
+        LOG_ERROR("mysql_stmt_init error: {}", mysql_error(sql_));
+        return nullptr;
+    }
+    if (mysql_stmt_prepare(stmt, query.data(), query.size()) != 0) {
+        LOG_ERROR("mysql_stmt_prepare error: {}", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+
+    //* 语句数量有上限,防止拼接出的动态 SQL 把服务端语句数占满
+    // 先淘汰最久未使用的再插入, 新语句不会被淘汰
+    if (stmts_.size() >= MAX_STMTS_) {
+        stmts_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    lru_.push_front(query);
+    auto& entry = stmts_[query];
+    entry.stmt = std::make_unique<SqlStmt>(stmt);
+    entry.lruIt = lru_.begin();
+    return entry.stmt.get();
+}
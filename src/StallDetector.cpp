@@ -0,0 +1,92 @@
+#include "StallDetector.h"
+
+#include <execinfo.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#include "EventLoop.h"
+#include "Log.h"
+
+namespace {
+
+constexpr int kMaxFrames{64};
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+}  // namespace
+
+void StallDetector::Start(int thresholdMs) {
+    if (thresholdMs <= 0 || running_.exchange(true)) {
+        return;
+    }
+    //! backtrace 第一次调用会加载 libgcc (分配内存), 不能在信号处理函数里发生, 先调用一次
+    void* frames[kMaxFrames];
+    backtrace(frames, kMaxFrames);
+
+    struct sigaction sa {};
+    sa.sa_handler = &StallDetector::DumpStack;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;  // 被打断的系统调用自动重启, 不影响 Loop 的 IO
+    sigaction(SIGUSR2, &sa, nullptr);
+
+    thread_ = std::thread(&StallDetector::Watch, thresholdMs);
+    LOG_INFO("StallDetector started: threshold {} ms", thresholdMs);
+}
+
+void StallDetector::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+void StallDetector::Register(EventLoop* loop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loops_[loop] = 0;
+}
+
+void StallDetector::Unregister(EventLoop* loop) {
+    //* 持锁注销: 之后后台线程不会再向这个线程发信号
+    std::lock_guard<std::mutex> lock(mutex_);
+    loops_.erase(loop);
+}
+
+void StallDetector::Watch(int thresholdMs) {
+    const int64_t thresholdNs = static_cast<int64_t>(thresholdMs) * 1000000;
+    const auto interval = std::chrono::milliseconds(std::max(1, thresholdMs / 2));
+    while (running_.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(interval);
+        int64_t now = NowNs();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [loop, reported] : loops_) {
+            int64_t start = loop->getIterationStartNs();
+            if (start == 0 || start == reported || now - start < thresholdNs) {
+                continue;
+            }
+            reported = start;
+            detected_.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("[Stall] loop {} blocked for {:.1f} ms, coroutine {} fd {}", loop->GetId(),
+                     (now - start) / 1e6, loop->getCurrentCoroutine(), loop->getCurrentFd());
+            pthread_kill(loop->getThread(), SIGUSR2);
+        }
+    }
+}
+
+void StallDetector::DumpStack(int /*sig*/) {
+    //! 信号处理函数: 只用 write / backtrace_symbols_fd, 不分配内存、不加锁
+    int savedErrno = errno;
+    static constexpr char kHeader[] = "[Stall] backtrace of blocked loop thread:\n";
+    write(STDERR_FILENO, kHeader, sizeof(kHeader) - 1);
+    void* frames[kMaxFrames];
+    int n = backtrace(frames, kMaxFrames);
+    backtrace_symbols_fd(frames, n, STDERR_FILENO);
+    errno = savedErrno;
+}
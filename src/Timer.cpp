@@ -1,5 +1,6 @@
 #include "Timer.h"
 
+#include "Histogram.h"
 #include "Log.h"
 
 void Timer::adjust(int id, int timeout, const TimeoutCallBack& callback) {
@@ -35,7 +36,7 @@ void Timer::doWork(int id) {
     del(index);       // 删除节点
 }
 
-void Timer::tick() {
+void Timer::tick(Histogram* lateness) {
     if (heap_.empty()) return;
     TimeStamp now = Clock::now();
     while (!heap_.empty()) {
@@ -43,9 +44,15 @@ void Timer::tick() {
         if (node.expire_time > now) {     // 没超时
             break;
         }
-        // 超时了,执行回调
-        node.callback();
+        if (lateness != nullptr) {
+            lateness->Record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - node.expire_time)
+                            .count()));
+        }
+        //! 先出堆再执行回调: 回调可能恢复协程并增删定时器,改变堆顶
+        TimeoutCallBack callback = std::move(node.callback);
         pop();
+        if (callback) callback();
     }
 }
 
@@ -3,196 +3,444 @@
 #include <sys/sendfile.h>  //sendfile
 
 #include <iostream>
+#include <optional>
 #include <sstream>
 
 #include "Buffer.h"
+#include "Affinity.h"
+#include "BlockingPool.h"
+#include "BufferPool.h"
+#include "ChainBuffer.h"
+#include "Dispatcher.h"
 #include "EventLoop.h"
+#include "FrameAllocator.h"
+#include "Histogram.h"
 #include "HttpRequest.h"
 #include "HttpResponse.h"
 #include "Log.h"
+#include "Metrics.h"
+#include "QueryCache.h"
 #include "Result.h"
+#include "Scheduler.h"
 #include "Socket.h"
 #include "SqlConnPool.h"
+#include "StallDetector.h"
 #include "Utils.h"
 #include "Worker.h"
 
-thread_local EventLoop* t_loop = nullptr;  // 线程局部变量,每个线程有一份独立的,全局可访问
 std::vector<std::unique_ptr<Worker>> workers;  // 线程池
+std::atomic<int> connCount{0};                  // 当前连接数
+
+// 登录查询,在每个连接上只 prepare 一次
+const std::string LOGIN_SQL = "SELECT password FROM user WHERE username = ? LIMIT 1";
+
+// 新连接分派策略: 长连接为主时用最少连接数, 避免 keep-alive 连接在个别 Worker 上堆积
+const Dispatcher::Policy DISPATCH_POLICY = Dispatcher::Policy::LeastConnections;
+
+// CPU 亲和性: Worker 绑核 + NUMA 本地内存 + 按网卡 RX 队列所在 CPU 分派
+// reservedCores > 0 时前几个核留给 Acceptor (主线程) 和日志线程, Worker 数相应减少
+const AffinityOptions AFFINITY{.pinWorkers = true, .reservedCores = 0, .numaLocal = true,
+                               .incomingCpu = true};
+
+// 阻塞任务线程池: 线程数与排队上限 (超过上限的请求直接拒绝)
+const int BLOCKING_THREADS = 4;
+const size_t BLOCKING_MAX_QUEUE = 1024;
+
+// EventLoop 埋点: 每轮耗时、epoll 事件数、任务排队时间、定时器延迟;
+// 一轮超过 LOOP_STALL_MS 记为卡顿, 并抓取卡住的线程的调用栈
+const bool LOOP_INSTRUMENT = true;
+const int LOOP_STALL_MS = 100;
+
+// 指标抓取路径 (Prometheus 文本格式)
+const std::string METRICS_PATH = "/metrics";
+
+// 按路由统计各阶段延迟 (未注册的路径记在 "other" 下)
+const int ROUTE_INDEX = RouteLatency::Register("/");
+const int ROUTE_LOGIN = RouteLatency::Register("/login");
+const int ROUTE_METRICS = RouteLatency::Register(METRICS_PATH);
+
+using SteadyClock = std::chrono::steady_clock;
+
+uint64_t NsSince(SteadyClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - start).count();
+}
+
+// 收到 SIGINT/SIGTERM 时停止主循环
+EventLoop* g_main_loop = nullptr;
+
+// 连接空闲/发送超时 (ms)
+const int IDLE_TIMEOUT_MS = 10000;
+
+// 用户密码缓存: 30s 过期,修改密码后需调用 userCache.Invalidate(user)
+QueryCache<std::optional<std::string>> userCache(4096, 30000);
+
+// 读取请求数据: 空闲等待期间不持有缓冲区,可读后再从本 Loop 的池里借
+// 返回读到的字节数, <= 0 表示对端关闭、出错或超时 (errno 为 ETIMEDOUT)
+Task<ssize_t> ReadRequest(Socket& client, BufferPool::Lease& readBuffer, IoOptions opts) {
+    if (readBuffer) {
+        // 上次还有半个请求没处理完,继续读到同一个缓冲区
+        co_return co_await client.Read(*readBuffer, std::move(opts));
+    }
+    if (int err = co_await client.WaitReadable(std::move(opts)); err != 0) {
+        errno = err;
+        co_return -1;
+    }
+    readBuffer = t_loop->GetBufferPool().Acquire();
+    co_return client.ReadAll(*readBuffer);
+}
+
+// Mysql 登录: 返回要展示的页面
+Task<std::string> HandleLogin(const HttpRequest& request) {
+    std::string user = request.getPost("user");
+    std::string pwd = request.getPost("pwd");
+
+    LOG_DEBUG("user = {}", user);
+    LOG_DEBUG("pwd = {}", pwd);
+
+    //* 先查缓存: 同一用户并发未命中时只有 leader 查库,其余协程挂起等它的结果
+    auto cached = co_await userCache.Lookup(user);
+    std::optional<std::string> password = cached.value;  // nullopt 表示用户不存在
+    if (!cached.hit) {
+        bool queried = false;
+        auto acquireStart = SteadyClock::now();
+        //* 获取连接: 连接全忙时协程排队挂起,最多等待 3s
+        SqlConn sqlConn = co_await SqlConnPool::getInstance()->Acquire(3000);
+        RouteLatency::Record(ROUTE_LOGIN, RouteLatency::kDbWait, NsSince(acquireStart));
+        if (!sqlConn) {
+            LOG_WARN("SqlConnPool Busy, acquire timeout");
+        } else {
+            char buf[64] = {0};
+            unsigned long len = 0;
+            //* prepare (连接首次使用或重连后) 和执行都是阻塞调用: 一起交给 BlockingPool,
+            //* 等待数据库期间本 Loop 继续服务其他连接
+            int ret = -1;
+            auto queryStart = SteadyClock::now();
+            try {
+                ret = co_await Offload([&sqlConn, &user, &buf, &len]() {
+                    SqlStmt* stmt = sqlConn.Stmt(LOGIN_SQL);
+                    if (stmt == nullptr) return -1;
+                    //* 预处理语句: 用户名作为参数单独发送,不拼接 SQL,无法注入
+                    stmt->BindParam(0, user);
+                    stmt->BindResult(0, buf, sizeof(buf), &len);
+                    return stmt->Execute() ? stmt->Fetch() : -1;
+                });
+            } catch (const OffloadRejected&) {
+                LOG_WARN("BlockingPool busy, login query rejected");
+            }
+            RouteLatency::Record(ROUTE_LOGIN, RouteLatency::kDbQuery, NsSince(queryStart));
+            if (ret == 1 && len > sizeof(buf)) {
+                //! 结果被截断: 按查询失败处理, 不能把存在的用户当成不存在缓存起来
+                LOG_WARN("Login query result truncated ({}B)", len);
+            } else {
+                queried = ret >= 0;
+                if (ret == 1) password = std::string(buf, len);
+            }
+        }
+        //* 查询成功才写缓存; 否则守卫析构时 Abandon, 由一个等待的协程接手重查, 其余继续等待
+        if (queried) {
+            cached.leader.Fill(password);
+        }
+    }
+
+    // 对比密码
+    bool loginOk = password.has_value() && *password == pwd;
+    co_return loginOk ? "/welcome.html" : "/error.html";  // 登录成功,显示欢迎页
+}
+
+// 发送响应: 头部 writev + Body sendfile, 返回 false 表示连接已不可写或发送超时
+Task<bool> SendResponse(Socket& client, HttpResponse& response, IoOptions opts) {
+    const int client_fd = client.getFd();
+
+    //* 生成响应数据 (头部写入分段缓冲区, 不做额外拷贝)
+    ChainBuffer headerBuffer;
+    response.MakeResponse(headerBuffer, client_fd);
+    Metrics::CountResponse(response.getCode());
+
+    // 发送前开启,TCP_CORK优化,避免 Header 和 Body 分成两个 TCP 包发
+    int on = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+
+    // 先发送Header: writev 聚集写, 只有发送缓冲区满时才挂起
+    bool ok = true;
+    while (headerBuffer.ReadableBytes() > 0) {
+        ssize_t n = co_await client.Writev(headerBuffer, opts);
+        if (n > 0) Metrics::Add(Metrics::kBytesWritev, n);
+        if (n == -1) {
+            if (errno == EAGAIN) continue;
+            if (errno == EPIPE || errno == ECONNRESET) {
+                LOG_WARN("Client {} disconnected (EPIPE)", client_fd);
+            } else if (errno == ETIMEDOUT || errno == ECANCELED) {
+                LOG_INFO("Client {} write {}", client_fd, errno == ETIMEDOUT ? "timeout" : "cancelled");
+            } else {
+                LOG_ERROR("Write failed: {}", strerror(errno));
+            }
+            ok = false;
+            break;
+        }
+        LOG_INFO("[AsyncWrite]已传输Header: {}B, 剩余{}B", n, headerBuffer.ReadableBytes());
+    }
+
+    // 如果是静态文件文件,使用 sendfile 发送 Body
+    if (ok && response.getFileFd() != -1 && response.getCode() == 200) {
+        ok = Utils::SendFile(client_fd, response.getFileFd(), response.getFileSize());
+        if (ok) LOG_INFO("SendFile 传输成功");
+    }
+
+    // 发送完关闭 CORK,强制刷出数据
+    int off = 0;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_CORK, &off, sizeof(off));
+    co_return ok;
+}
+
+// 短连接发完后优雅关闭
+void CloseGracefully(int client_fd) {
+    //* 以下是webbench需要:
+    // 关闭写端，告诉客户端：我数据发完了
+    // 这会向客户端发送 FIN 包
+    shutdown(client_fd, SHUT_WR);
+
+    // 尝试读取客户端可能发来的剩余数据（虽然通常没有）
+    // 这是为了让内核完成正常的四次挥手，避免 RST
+    char dummy[1024];
+    while (true) {
+        int n = read(client_fd, dummy, sizeof(dummy));
+        if (n <= 0) {
+            // n == 0 代表客户端也关闭了连接 (FIN)
+            // n == -1 代表出错，不管怎样都可以结束了
+            break;
+        }
+    }
+}
 
 // 处理客户端连接的协程
 Task<void> HandleClient(Socket client) {
+    connCount.fetch_add(1, std::memory_order_relaxed);
     //! 必须用 std::move 接管 client,否则析构会关闭fd
-    Buffer readBuffer;
+    // 读缓冲区从本 Loop 的池里借, 只在有数据待处理时持有, 空闲的长连接不占内存
+    BufferPool::Lease readBuffer;
     HttpRequest request;
     HttpResponse response;
     const int client_fd = client.getFd();
 
-    auto timeoutCb = [client_fd]() {
-        LOG_INFO("Client {} Timeout, closing...", client_fd);
-        // 关闭文件描述符,这将导致 epoll_wait 返回错误或 read 返回 -1, 从而唤醒协程
-        shutdown(client_fd, SHUT_RDWR);
-    };
-
-    while (true) {
-        //* 添加/更新定时器 (比如10s超时)
-        if (t_loop != nullptr) {
-            t_loop->UpdateTimer(client_fd, 10000, timeoutCb);
-        }
-
-        //* 协程挂起,等待数据读入 Buffer
-        ssize_t n = co_await client.Read(readBuffer);
+    bool alive = true;
+    while (alive) {
+        //* 协程挂起,等待数据读入 Buffer: 空闲超过 10s 由 EventLoop 以 ETIMEDOUT 直接恢复
+        ssize_t n = co_await ReadRequest(client, readBuffer, {Deadline::After(IDLE_TIMEOUT_MS)});
 
         // *对端关闭或超时 直接退出循环,销毁协程
         if (n <= 0) {
+            if (n < 0 && errno == ETIMEDOUT) {
+                LOG_INFO("Client {} Timeout, closing...", client_fd);
+            }
             break;
         }
 
         //* 循环处理 Buffer 中的请求
-        while (request.Parse(readBuffer)) {
+        auto parseStart = SteadyClock::now();
+        while (alive && request.Parse(*readBuffer)) {
             //* 处理业务逻辑
-            std::string_view path = request.getPath();
-            //! 拦截API请求
-            // Mysql 登录
-            if (path == "/login" && request.getMethod() == "POST") {
-                std::string user = request.getPost("user");
-                std::string pwd = request.getPost("pwd");
-
-                LOG_DEBUG("user = {}", user);
-                LOG_DEBUG("pwd = {}", pwd);
-
-                // 获取连接
-                MYSQL* sql = nullptr;
-                SqlConn sqlConn(&sql, SqlConnPool::getInstance());
-
-                LOG_INFO("Mysql Connect Success");
-
-                // 执行查询
-                char order[256] = {0};
-                snprintf(order, 256,
-                         "SELECT username,password FROM user WHERE username='%s' LIMIT 1",
-                         user.c_str());
-
-                if (mysql_query(sql, order)) {
-                    // 查询失败...
-                }
+            std::string path(request.getPath());
+            const int route = RouteLatency::Find(path);
+            auto handlerStart = SteadyClock::now();
+            RouteLatency::Record(route, RouteLatency::kParse, NsSince(parseStart));
 
-                MYSQL_RES* result = mysql_store_result(sql);
-                // 解析结果对比密码...
-                mysql_free_result(result);
-
-                if (user == "root" && pwd == "123") {
-                    path = "/welcome.html";  // 登录成功,显示欢迎页
-                } else {
-                    path = "/error.html";
+            bool keepAlive = request.IsKeepAlive();
+            if (route == ROUTE_METRICS && request.getMethod() == "GET") {
+                //* 指标: 抓取时才汇总各线程的计数和直方图. 汇总和格式化是纯计算,
+                //* 交给工作窃取调度, 空闲的 Worker 会把它接走, 本 Loop 继续处理其他连接的 IO
+                std::string body =
+                        co_await Compute([]() { return Metrics::Render() + RouteLatency::Render(); });
+                response.InitContent(std::move(body), "text/plain; version=0.0.4", keepAlive);
+            } else {
+                //! 拦截API请求
+                if (path == "/login" && request.getMethod() == "POST") {
+                    path = co_await HandleLogin(request);
+                } else if (path == "/") {
+                    path = "/index.html";  // 默认页
                 }
-            } else if (path == "/") {
-                path = "/index.html";  // 默认页
-            }
 
-            //* 初始化响应
-            bool keepAlive = request.IsKeepAlive();
-            std::string path1 = std::string(path);
-            response.Init("../resources", path1, keepAlive, 200);
+                //* 初始化响应
+                response.Init("../resources", path, keepAlive, 200);
+            }
 
-            //* 生成响应数据
-            Buffer headerBuffer;
-            response.MakeResponse(headerBuffer, client_fd);
+            RouteLatency::Record(route, RouteLatency::kHandler, NsSince(handlerStart));
 
             //* 发送响应
-            // 发送前开启,TCP_CORK优化,避免 Header 和 Body 分成两个 TCP 包发
-            int on = 1;
-            setsockopt(client_fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
-
-            // 先发送Header
-            // 异步write 发送循环
-            size_t total = headerBuffer.ReadableBytes();
-            size_t sent = 0;
-            while (sent < total) {
-                ssize_t n = co_await client.Write(headerBuffer.Peek() + sent, total - sent);
-                if (n == -1) {
-                    if (errno == EPIPE || errno == ECONNRESET) {
-                        LOG_WARN("Client {} disconnected (EPIPE)", client_fd);
-                    } else {
-                        LOG_ERROR("Write failed: {}", strerror(errno));
-                    }
-                    break;
-                }
-                sent += n;
-                LOG_INFO("[AsyncWrite]已传输Header: {}B, 剩余{}B", sent, total - sent);
-            }
+            alive = co_await SendResponse(client, response, {Deadline::After(IDLE_TIMEOUT_MS)});
+            RouteLatency::Record(route, RouteLatency::kLastByte, NsSince(parseStart));
 
-            // 如果是静态文件文件,使用 sendfile 发送 Body
-            if (response.getFileFd() != -1 && response.getCode() == 200) {
-                if (Utils::SendFile(client_fd, response.getFileFd(), response.getFileSize()))
-                    LOG_INFO("SendFile 传输成功");
-            }
-
-            // 发送完关闭 CORK,强制刷出数据
-            int off = 0;
-            setsockopt(client_fd, IPPROTO_TCP, TCP_CORK, &off, sizeof(off));
-
-            if (!keepAlive) {  // 如果是短连接,发完就关
-                //* 以下是webbench需要:
-                // 关闭写端，告诉客户端：我数据发完了
-                // 这会向客户端发送 FIN 包
-                shutdown(client_fd, SHUT_WR);
-
-                // 尝试读取客户端可能发来的剩余数据（虽然通常没有）
-                // 这是为了让内核完成正常的四次挥手，避免 RST
-                char dummy[1024];
-                while (true) {
-                    int n = read(client_fd, dummy, sizeof(dummy));
-                    if (n <= 0) {
-                        // n == 0 代表客户端也关闭了连接 (FIN)
-                        // n == -1 代表出错，不管怎样都可以结束了
-                        break;
-                    }
-                }
+            if (alive && !keepAlive) {  // 如果是短连接,发完就关
+                CloseGracefully(client_fd);
             }
 
             // 重置 request 状态，准备处理下一个请求 (Keep-Alive)
             request.Init();
+            parseStart = SteadyClock::now();
         }
-        //* 协程结束，Task 析构，client 析构，连接关闭
-        // 移除定时器
-        if (t_loop != nullptr) {
-            t_loop->DelTimer(client_fd);
+        //* 数据处理完,归还缓冲区 (大缓冲区在池里收缩); 残留半个请求时继续持有
+        if (readBuffer->ReadableBytes() == 0) {
+            readBuffer.Release();
         }
     }
+    //* 协程结束，Task 析构，client 析构，连接关闭
+    connCount.fetch_sub(1, std::memory_order_relaxed);
+    t_loop->AddConnections(-1);  // 与 Dispatcher::Pick 的 +1 配对
+}
+
+// 每 60s 输出一次内存统计: RSS/连接数、各 Worker 读缓冲区池的占用, 以及阻塞任务线程池的排队情况
+void ReportMemory(EventLoop* loop, int timerId) {
+    size_t inUse = 0, idle = 0, idleBytes = 0;
+    uint64_t shrinks = 0;
+    for (auto& worker : workers) {
+        BufferPool& pool = worker->getLoop()->GetBufferPool();
+        inUse += pool.getInUse();
+        idle += pool.getIdle();
+        idleBytes += pool.getIdleBytes();
+        shrinks += pool.getShrinkCount();
+    }
+    size_t rss = Utils::GetRssBytes();
+    int conns = connCount.load(std::memory_order_relaxed);
+    LOG_INFO("[Memory] rss={}KB conns={} rss/conn={}B buffers in-use={} idle={} ({}KB) shrinks={}",
+             rss / 1024, conns, conns > 0 ? rss / conns : 0, inUse, idle, idleBytes / 1024,
+             shrinks);
+    FrameAllocator::Stats frames = FrameAllocator::getStats();
+    LOG_INFO("[Memory] coroutine frames live={} ({}KB) allocs={} pool-hits={} remote-frees={}",
+             frames.liveFrames, frames.liveBytes / 1024, frames.allocs, frames.poolHits,
+             frames.remoteFrees);
+    BlockingPool::Stats offload = BlockingPool::getInstance()->getStats();
+    LOG_INFO("[Offload] submitted={} rejected={} queued={} running={} avg-wait={}us max-wait={}us "
+             "avg-run={}us",
+             offload.submitted, offload.rejected, offload.queued, offload.running,
+             offload.completed > 0 ? offload.waitNs / offload.completed / 1000 : 0,
+             offload.maxWaitNs / 1000,
+             offload.completed > 0 ? offload.runNs / offload.completed / 1000 : 0);
+    loop->AddTimer(timerId, 60000, [loop, timerId]() { ReportMemory(loop, timerId); });
+}
+
+// 注册抓取时读取的指标: 每个 Worker 的连接数/队列深度/定时器数, 各个池和日志的状态
+void RegisterMetrics() {
+    using Type = Metrics::Type;
+    for (auto& worker : workers) {
+        EventLoop* loop = worker->getLoop();
+        std::string label = fmt::format("loop=\"{}\"", loop->GetId());
+        Metrics::Register("webserver_loop_connections", "Active connections per EventLoop",
+                          Type::Gauge, label, [loop]() { return loop->getConnections(); });
+        Metrics::Register("webserver_loop_queue_depth",
+                          "Pending cross-thread tasks and stealable jobs per EventLoop", Type::Gauge,
+                          label, [loop]() { return loop->getQueueDepth(); });
+        Metrics::Register("webserver_loop_timers", "Armed timers per EventLoop", Type::Gauge, label,
+                          [loop]() { return loop->getTimerCount(); });
+        if (!EventLoop::IsInstrumented()) continue;
+        // 埋点直方图的 p99 (微秒)
+        auto p99Us = [](const Histogram& histogram) {
+            Histogram::Snapshot snapshot;
+            histogram.AddTo(snapshot);
+            return static_cast<int64_t>(snapshot.Percentile(0.99) / 1000);
+        };
+        const LoopStats& stats = loop->getStats();
+        Metrics::Register("webserver_loop_iteration_p99_microseconds",
+                          "p99 time spent handling one EventLoop iteration", Type::Gauge, label,
+                          [&stats, p99Us]() { return p99Us(stats.iterationNs); });
+        Metrics::Register("webserver_loop_task_wait_p99_microseconds",
+                          "p99 time a cross-thread task waited before running", Type::Gauge, label,
+                          [&stats, p99Us]() { return p99Us(stats.taskWaitNs); });
+        Metrics::Register("webserver_loop_timer_lateness_p99_microseconds",
+                          "p99 delay between a timer's deadline and its callback", Type::Gauge, label,
+                          [&stats, p99Us]() { return p99Us(stats.timerLateNs); });
+        Metrics::Register("webserver_loop_stalls_total",
+                          "EventLoop iterations longer than the stall threshold", Type::Counter, label,
+                          [&stats]() {
+                              return static_cast<int64_t>(stats.stalls.load(std::memory_order_relaxed));
+                          });
+    }
+    Metrics::Register("webserver_db_pool_connections", "Live MySQL connections", Type::Gauge, "",
+                      []() { return SqlConnPool::getInstance()->getConnCount(); });
+    Metrics::Register("webserver_db_pool_waiters", "Coroutines waiting for a MySQL connection",
+                      Type::Gauge, "", []() { return SqlConnPool::getInstance()->getWaiterCount(); });
+    Metrics::Register("webserver_db_pool_wait_timeouts_total", "MySQL connection wait timeouts",
+                      Type::Counter, "", []() {
+                          return static_cast<int64_t>(
+                                  SqlConnPool::getInstance()->getWaitTimeoutCount());
+                      });
+    Metrics::Register("webserver_db_pool_reconnects_total", "MySQL connections re-established",
+                      Type::Counter, "", []() {
+                          return static_cast<int64_t>(SqlConnPool::getInstance()->getReconnectCount());
+                      });
+    Metrics::Register("webserver_db_pool_steals_total",
+                      "MySQL connections taken from a sibling shard", Type::Counter, "", []() {
+                          return static_cast<int64_t>(SqlConnPool::getInstance()->getStealCount());
+                      });
+    //* 获取连接的等待时间分布: 第 i 个桶为 < 2^i 微秒
+    std::vector<double> waitBounds;
+    for (int i = 0; i < SqlConnPool::kWaitBuckets - 1; ++i) {
+        waitBounds.push_back(static_cast<double>(1LL << i) / 1e6);
+    }
+    Metrics::RegisterHistogram("webserver_db_pool_wait_duration_seconds",
+                               "Time to acquire a MySQL connection", std::move(waitBounds), []() {
+                                   Metrics::HistogramSample sample;
+                                   sample.counts = SqlConnPool::getInstance()->getWaitHistogram();
+                                   sample.sum = Metrics::Get(Metrics::kDbWaitNs) / 1e9;
+                                   return sample;
+                               });
+    Metrics::Register("webserver_offload_queued", "Jobs queued in the blocking pool", Type::Gauge, "",
+                      []() { return BlockingPool::getInstance()->getStats().queued; });
+    Metrics::Register("webserver_offload_rejected_total", "Jobs rejected by the blocking pool",
+                      Type::Counter, "", []() {
+                          return static_cast<int64_t>(BlockingPool::getInstance()->getStats().rejected);
+                      });
+    Metrics::Register("webserver_log_dropped_total", "Log records dropped on full buffers",
+                      Type::Counter, "",
+                      []() { return static_cast<int64_t>(Log::getInstance()->getDroppedCount()); });
 }
 
 // 接收连接的协程
-Task<void> Acceptor(Socket& server) {
-    int next_worker{0};
-    LOG_INFO("Acceptor started");
+Task<void> Acceptor(Socket& server, Dispatcher& dispatcher, bool incomingCpu) {
+    LOG_INFO("Acceptor started, dispatch policy: {}",
+             Dispatcher::PolicyName(dispatcher.getPolicy()));
     while (true) {
-        Buffer buf;
-        co_await server.Read(buf);  // 挂起  只要等待事件,不读数据 awaiter是封装的可等待对象(read版)
+        // 挂起  只要等待事件,不读数据; Loop 停止时以 ECANCELED 恢复,退出协程
+        if (co_await server.WaitReadable() != 0) {
+            break;
+        }
         // 从 co_await 醒来(调度器EventLoop调用resume)说明有连接
-        Socket client = server.Accept();
+        sockaddr_in peer{};
+        Socket client = server.Accept(&peer);
         int client_fd = client.getFd();
         //! 注意：释放 client 对象对 fd 的所有权，防止析构时 close
         client.Release();
         if (client_fd >= 0) {
-            LOG_INFO("New Connection: {} -> Dispatch to Worker {}", client_fd, next_worker);
+            Metrics::Add(Metrics::kAcceptedConnections);
+            //* 按策略挑选 Worker (已计入它的连接数), 优先处理其入站包的核上的 Worker
+            size_t target =
+                dispatcher.Pick(peer, incomingCpu ? Affinity::GetIncomingCpu(client_fd) : -1);
+            LOG_INFO("New Connection: {} -> Dispatch to Worker {}", client_fd, target);
             // 关键：把 Socket 移动到 Worker 线程去处理
             // 启动处理协程
-            workers[next_worker]->getLoop()->RunInLoop([client_fd]() {
+            workers[target]->getLoop()->RunInLoop([client_fd]() {
                 // 在子线程重新包装成 Socket
                 Socket c(client_fd);
                 c.SetNonBlocking();
-                HandleClient(std::move(c));
+                HandleClient(std::move(c)).Detach();
             });
-
-            // 轮询下一个
-            next_worker = (next_worker + 1) % workers.size();
         }
     }
 }
 
+// SIGINT/SIGTERM: 只做异步信号安全的操作 (原子置位 + 写 eventfd), 收尾在主循环退出后进行
+void HandleStopSignal(int) {
+    if (g_main_loop != nullptr) {
+        g_main_loop->Stop();
+        g_main_loop->WakeUp();
+    }
+}
+
 int main() {
     signal(SIGPIPE, SIG_IGN);  // webbench需要: 忽略 SIGPIPE 信号，防止进程意外退出
 
+    //! 划分 CPU 要在启动日志之前: 主线程先绑到预留核, 之后创建的日志线程继承这个亲和性
+    const Affinity::Plan cpuPlan = Affinity::MakePlan(AFFINITY);
+    Affinity::PinCurrentThread(cpuPlan.reservedCpus);
+
     // 初始化日志(开启异步,队列长度 1024)
     Log::getInstance()->Init(3, "./log", ".log", 1024);
 
@@ -204,16 +452,33 @@ int main() {
     // 将 fd 限制增加为65535
     Utils::setRlimit();
 
-    // 初始化 Mysql 连接池
-    SqlConnPool::getInstance()->Init("localhost", 3306, "root", "20050430", "webserver", 16);
+    const int core_num = std::thread::hardware_concurrency();  // 获取CPU核心数
+    const int thread_num = cpuPlan.workerNum;                  // 每个未预留的核一个 Worker
+
+    // 初始化 Mysql 连接池: 每个 Worker 一个分片,每片至少 2 个连接
+    const int sql_conn_num = std::max(16, thread_num * 2);
+    SqlConnPool::getInstance()->Init("localhost", 3306, "root", "20050430", "webserver",
+                                     sql_conn_num, thread_num);
+    // 后台健康检查: 每 5s ping 空闲连接并重连,排队时扩容到 2 倍,空闲 60s 收缩到每 Worker 1 个
+    SqlConnPool::getInstance()->StartHealthCheck(thread_num, sql_conn_num * 2, 5000, 60000);
+
+    // 阻塞任务线程池: 运行阻塞的 MySQL 语句等, 线程需要 libmysqlclient 的线程初始化
+    BlockingPool::getInstance()->Init(BLOCKING_THREADS, BLOCKING_MAX_QUEUE, mysql_thread_init,
+                                      mysql_thread_end);
+
+    // Loop 埋点要在创建 Worker 之前开启
+    if (LOOP_INSTRUMENT) {
+        EventLoop::EnableInstrumentation(LOOP_STALL_MS);
+        StallDetector::Start(LOOP_STALL_MS);
+    }
 
     // 启动 thread_num 个 Worker
-    const int core_num = std::thread::hardware_concurrency();  // 获取CPU核心数
-    const int thread_num = core_num;
     LOG_INFO("Core num: {}", core_num);
     LOG_INFO("Worker Thread num: {}", thread_num);
+    LOG_INFO("Reserved cores: {}, pin workers: {}, NUMA nodes: {}", cpuPlan.reservedCpus.size(),
+             !cpuPlan.workerCpus.empty(), Affinity::NodeCount());
     for (int i = 0; i < thread_num; ++i) {
-        workers.push_back(std::make_unique<Worker>());
+        workers.push_back(std::make_unique<Worker>(i, cpuPlan.CpusOf(i), AFFINITY.numaLocal));
     }
     // 启动 server
     Socket server;
@@ -226,12 +491,44 @@ int main() {
     EventLoop main_loop;
     // 2.设置 TLS 指针,让该线程内的协程能找到他
     t_loop = &main_loop;
+    g_main_loop = &main_loop;
+    signal(SIGINT, HandleStopSignal);
+    signal(SIGTERM, HandleStopSignal);
     // 3.启动 Acceptor 协程
-    Acceptor(server);
+    std::vector<EventLoop*> worker_loops;
+    for (auto& worker : workers) {
+        worker_loops.push_back(worker->getLoop());
+    }
+    Scheduler::SetLoops(worker_loops);  // Worker 之间的工作窃取
+    Dispatcher dispatcher(std::move(worker_loops), DISPATCH_POLICY);
+    dispatcher.SetWorkerCpus(cpuPlan.workerCpus);
+    RegisterMetrics();
+    Acceptor(server, dispatcher, AFFINITY.incomingCpu).Detach();
+    // 定时输出内存统计
+    const int memTimerId = main_loop.NewTimerId();
+    main_loop.AddTimer(memTimerId, 60000,
+                       [&main_loop, memTimerId]() { ReportMemory(&main_loop, memTimerId); });
     // 4.运行 Loop
     LOG_INFO("MainLoop is ready");
     main_loop.Loop();
 
+    //* 收尾: 先停阻塞任务线程池 (完成的任务还要投递回 Worker), 再停 Worker, 最后关连接池
+    LOG_INFO("Stop signal received, shutting down...");
+    g_main_loop = nullptr;
+    BlockingPool::getInstance()->Shutdown();
+    //! 先停止并 join 所有 Worker, 再注销窃取、析构 Loop: 仍在运行的 Worker 可能正在窃取其他 Loop 的任务
+    for (auto& worker : workers) worker->Stop();
+    for (auto& worker : workers) worker->Join();
+    Scheduler::Reset();
+    workers.clear();
+    StallDetector::Stop();
+    SqlConnPool::getInstance()->ClosePool();
+    // 延迟直方图同时写到标准输出: 日志级别可能过滤掉 INFO
+    std::string latency = RouteLatency::Dump();
+    std::cout << "Request latency by route:\n" << latency << std::flush;
+    LOG_INFO("Request latency by route:\n{}", latency);
+
     LOG_INFO("========== Server End ==========");
+    Log::getInstance()->Flush();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+// FrameAllocator 多线程压力测试: 各线程分配不同尺寸的块 (含超过最大级别的大块), 经队列交给
+// 其他线程释放 (跨线程释放), 以及分配线程先退出、块由其他线程最后释放 (线程缓存移交).
+// 检查: 存活块之间不重叠 (每块写满自己的标记, 释放前校验), 结束后没有存活块,
+// 全局 operator new/delete 的未释放次数回到基线 (线程缓存和空闲块都已归还)
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "FrameAllocator.h"
+#include "MpmcQueue.h"
+
+namespace {
+std::atomic<int64_t> g_outstanding{0};  // 全局 operator new 未释放的次数
+}  // namespace
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    g_outstanding.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+void operator delete(void* p) noexcept {
+    if (p == nullptr) return;
+    g_outstanding.fetch_sub(1, std::memory_order_relaxed);
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+namespace {
+
+struct Block {
+    uint64_t* data;
+    size_t words;
+    uint64_t tag;
+};
+
+size_t SizeOf(uint64_t seed) {
+    // 覆盖所有级别和大块: 16B ~ 12KB
+    static const size_t kSizes[] = {16, 100, 200, 500, 1000, 2000, 4000, 8000, 12000};
+    return kSizes[seed % (sizeof(kSizes) / sizeof(kSizes[0]))];
+}
+
+Block Allocate(uint64_t tag) {
+    size_t size = SizeOf(tag * 2654435761ULL >> 7);
+    auto* data = static_cast<uint64_t*>(FrameAllocator::Allocate(size));
+    size_t words = size / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) data[i] = tag;
+    return {data, words, tag};
+}
+
+void Free(const Block& block) {
+    for (size_t i = 0; i < block.words; ++i) {
+        CHECK(block.data[i] == block.tag);  // 块被重复分配时标记会被覆盖
+    }
+    FrameAllocator::Deallocate(block.data);
+}
+
+// 一轮: producers 个线程各分配 perThread 块, 一半本线程释放, 一半交给 freers 个线程释放.
+// exitFirst 为 true 时, 分配线程全部退出后才开始跨线程释放
+void Run(int producers, int freers, int perThread, bool exitFirst) {
+    std::atomic<uint64_t> nextTag{1};
+    std::vector<std::thread> producerThreads;
+    std::vector<std::thread> freerThreads;
+    if (exitFirst) {
+        // 队列要装得下所有跨线程释放的块
+        auto big = std::make_unique<MpmcQueue<Block>>(static_cast<size_t>(producers * perThread));
+        auto produceAll = [&]() {
+            for (int i = 0; i < perThread; ++i) {
+                CHECK(big->try_push(Allocate(nextTag.fetch_add(1, std::memory_order_relaxed))));
+            }
+        };
+        for (int p = 0; p < producers; ++p) producerThreads.emplace_back(produceAll);
+        for (auto& t : producerThreads) t.join();  // 分配线程已退出, 块仍存活
+        big->shutdown();
+        for (int f = 0; f < freers; ++f) {
+            freerThreads.emplace_back([queue = big.get()]() {
+                Block block{};
+                while (queue->pop(block)) Free(block);
+            });
+        }
+        for (auto& t : freerThreads) t.join();
+    } else {
+        MpmcQueue<Block> queue(1024);
+        auto produce = [&]() {
+            std::vector<Block> local;
+            for (int i = 0; i < perThread; ++i) {
+                Block block = Allocate(nextTag.fetch_add(1, std::memory_order_relaxed));
+                if (i % 2 == 0) {
+                    CHECK(queue.push_back(block));
+                } else {
+                    local.push_back(block);
+                }
+                // 本线程分配/释放交错, 期间取回其他线程释放的块
+                if (local.size() > 8) {
+                    Free(local.front());
+                    local.erase(local.begin());
+                }
+            }
+            for (auto& block : local) Free(block);
+        };
+        auto drain = [&]() {
+            Block block{};
+            while (queue.pop(block)) {
+                Free(block);
+                // 释放线程自己也分配, 可能复用到其他线程释放的块
+                Block mine = Allocate(nextTag.fetch_add(1, std::memory_order_relaxed));
+                Free(mine);
+            }
+        };
+
+        for (int f = 0; f < freers; ++f) freerThreads.emplace_back(drain);
+        for (int p = 0; p < producers; ++p) producerThreads.emplace_back(produce);
+        for (auto& t : producerThreads) t.join();
+        queue.shutdown();
+        for (auto& t : freerThreads) t.join();
+    }
+}
+
+void RunChecked(int producers, int freers, int perThread, bool exitFirst) {
+    // 先跑一轮预热: 统计登记表 (故意不释放) 的容量增长不计入基线
+    Run(producers, freers, perThread, exitFirst);
+    int64_t baseline = g_outstanding.load();
+    Run(producers, freers, perThread, exitFirst);
+    FrameAllocator::Stats stats = FrameAllocator::getStats();
+    std::printf("producers=%d freers=%d perThread=%d exitFirst=%d remoteFrees=%llu live=%zu "
+                "outstanding=%lld\n",
+                producers, freers, perThread, exitFirst,
+                static_cast<unsigned long long>(stats.remoteFrees), stats.liveFrames,
+                static_cast<long long>(g_outstanding.load() - baseline));
+    CHECK(stats.liveFrames == 0);
+    CHECK(stats.liveBytes == 0);
+    CHECK(g_outstanding.load() == baseline);  // 没有泄漏的块或线程缓存
+}
+
+}  // namespace
+
+int main() {
+    RunChecked(4, 2, 20000, false);
+    RunChecked(4, 3, 5000, true);
+    std::printf("FrameAllocatorTest passed\n");
+    return 0;
+}
@@ -0,0 +1,98 @@
+// MpmcQueue 多线程压力测试: 多个生产者/消费者混用单个与批量接口, 容量很小以反复触发满/空等待,
+// 检查每个元素恰好被取出一次, 且同一生产者的元素在同一消费者看来保持 FIFO 顺序
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "MpmcQueue.h"
+
+namespace {
+
+constexpr size_t BATCH = 16;
+
+// 元素编码: 高 16 位为生产者编号, 低位为该生产者的序号
+uint64_t Encode(uint64_t producer, uint64_t seq) { return producer << 48 | seq; }
+uint64_t ProducerOf(uint64_t item) { return item >> 48; }
+uint64_t SeqOf(uint64_t item) { return item & ((1ULL << 48) - 1); }
+
+void Run(int producers, int consumers, uint64_t perProducer, size_t capacity) {
+    MpmcQueue<uint64_t> queue(capacity);
+    std::vector<std::atomic<int>> seen(producers * perProducer);
+
+    std::vector<std::thread> consumerThreads;
+    for (int c = 0; c < consumers; ++c) {
+        consumerThreads.emplace_back([&, c]() {
+            std::vector<int64_t> last(producers, -1);  // 每个生产者最近取到的序号
+            auto take = [&](uint64_t item) {
+                uint64_t p = ProducerOf(item);
+                uint64_t seq = SeqOf(item);
+                CHECK(p < static_cast<uint64_t>(producers) && seq < perProducer);
+                CHECK(static_cast<int64_t>(seq) > last[p]);  // 同一生产者保持顺序
+                last[p] = static_cast<int64_t>(seq);
+                CHECK(seen[p * perProducer + seq].fetch_add(1, std::memory_order_relaxed) == 0);
+            };
+            uint64_t items[BATCH];
+            while (true) {
+                if (c % 2 == 0) {
+                    uint64_t item = 0;
+                    if (!queue.pop(item)) break;  // shutdown 且已取空
+                    take(item);
+                } else {
+                    size_t n = queue.pop_n(items, BATCH);
+                    for (size_t i = 0; i < n; ++i) take(items[i]);
+                    if (n == 0) {
+                        // 批量取空后用阻塞接口等待, shutdown 且已取空时结束
+                        uint64_t item = 0;
+                        if (!queue.pop(item)) break;
+                        take(item);
+                    }
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> producerThreads;
+    for (int p = 0; p < producers; ++p) {
+        producerThreads.emplace_back([&, p]() {
+            uint64_t seq = 0;
+            uint64_t items[BATCH];
+            while (seq < perProducer) {
+                if (p % 2 == 0) {
+                    CHECK(queue.push_back(Encode(p, seq)));
+                    ++seq;
+                } else {
+                    size_t n = 0;
+                    while (n < BATCH && seq + n < perProducer) {
+                        items[n] = Encode(p, seq + n);
+                        ++n;
+                    }
+                    size_t pushed = queue.push_n(items, n);
+                    seq += pushed;
+                    if (pushed == 0) std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : producerThreads) t.join();
+    queue.shutdown();
+    for (auto& t : consumerThreads) t.join();
+
+    for (size_t i = 0; i < seen.size(); ++i) {
+        CHECK(seen[i].load() == 1);
+    }
+    std::printf("producers=%d consumers=%d items=%llu capacity=%zu\n", producers, consumers,
+                static_cast<unsigned long long>(producers * perProducer), capacity);
+}
+
+}  // namespace
+
+int main() {
+    Run(4, 4, 50000, 8);
+    Run(1, 3, 100000, 64);
+    Run(3, 1, 50000, 2);
+    std::printf("MpmcQueueTest passed\n");
+    return 0;
+}
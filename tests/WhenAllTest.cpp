@@ -0,0 +1,170 @@
+// WhenAll / WhenAny 组合器测试: 在本线程的 EventLoop 上运行,
+// 子任务用永远不会就绪的管道 + IoOptions (截止时间 / 取消令牌) 模拟耗时 IO
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "EventLoop.h"
+#include "IoAwaitable.h"
+#include "WhenAll.h"
+
+namespace {
+
+// 一个不会有数据的管道: 在它上面等待只会因超时或取消结束
+struct IdlePipe {
+    int fds[2]{-1, -1};
+    IdlePipe() { CHECK(pipe(fds) == 0); }
+    ~IdlePipe() {
+        close(fds[0]);
+        close(fds[1]);
+    }
+};
+
+// 等待 ms 毫秒或被取消, 返回 ETIMEDOUT / ECANCELED
+Task<int> Sleep(int ms, CancellationToken token = {}) {
+    IdlePipe idle;
+    //! 等待体放在具名变量里: GCC 12 对 co_await 表达式中带非平凡析构的临时对象会重复析构
+    IoAwaitable wait{idle.fds[0], EPOLLIN, IoOptions{Deadline::After(ms), std::move(token)}};
+    co_return co_await wait;
+}
+
+int64_t ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                 start)
+        .count();
+}
+
+Task<int> Value(int ms, int value) {
+    co_await Sleep(ms);
+    co_return value;
+}
+
+Task<void> Nothing() { co_return; }
+
+Task<std::string> Text(std::string text) { co_return text; }
+
+Task<int> Fail(int ms) {
+    co_await Sleep(ms);
+    throw std::runtime_error("fail");
+}
+
+Task<void> TestWhenAll() {
+    //* 异构版本: 同步完成与挂起的任务混合, 结果按参数顺序
+    auto [a, none, text] = co_await WhenAll(Value(20, 1), Nothing(), Text("ok"));
+    CHECK(a == 1);
+    CHECK(none == std::monostate{});
+    CHECK(text == "ok");
+
+    //* 批量版本: 并发等待, 总耗时接近最慢的一个而不是总和
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Task<int>> tasks;
+    for (int i = 0; i < 5; ++i) tasks.push_back(Value(30, i));
+    auto values = co_await WhenAll(std::move(tasks));
+    CHECK(ElapsedMs(start) < 120);
+    CHECK(values.size() == 5);
+    for (int i = 0; i < 5; ++i) CHECK(values[i] == i);
+
+    //* 异常: 等全部结束后才重新抛出
+    int finished = 0;
+    auto slow = [&finished]() -> Task<int> {
+        co_await Sleep(40);
+        ++finished;
+        co_return 0;
+    };
+    bool thrown = false;
+    try {
+        co_await WhenAll(Fail(5), slow());
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(finished == 1);
+}
+
+Task<void> TestWhenAny() {
+    //* 最快的任务胜出; 落选任务被取消, 且都结束后等待方才恢复
+    //* 落选任务引用等待方帧里的变量: 恢复前它们必须已经写完
+    {
+        CancellationSource cancel;
+        int cancelled = 0;
+        int finished = 0;
+        auto loser = [&](bool honorToken) -> Task<int> {
+            CancellationToken token = honorToken ? cancel.Token() : CancellationToken{};
+            int err = co_await Sleep(honorToken ? 5000 : 60, std::move(token));
+            if (err == ECANCELED) ++cancelled;
+            ++finished;
+            co_return -1;
+        };
+        std::vector<Task<int>> tasks;
+        tasks.push_back(loser(true));
+        tasks.push_back(Value(10, 42));
+        tasks.push_back(loser(true));
+        tasks.push_back(loser(false));  // 不理会取消的任务也要等它结束
+
+        auto start = std::chrono::steady_clock::now();
+        auto [index, value] = co_await WhenAny(std::move(tasks), cancel);
+        CHECK(index == 1);
+        CHECK(value == 42);
+        CHECK(cancel.IsCancelled());
+        CHECK(cancelled == 2);
+        CHECK(finished == 3);
+        CHECK(ElapsedMs(start) < 1000);
+    }
+
+    //* 同步完成的任务直接胜出, 其余任务在启动时就看到已取消
+    {
+        CancellationSource cancel;
+        int cancelled = 0;
+        auto waiter = [&]() -> Task<int> {
+            if (co_await Sleep(5000, cancel.Token()) == ECANCELED) ++cancelled;
+            co_return 0;
+        };
+        std::vector<Task<int>> tasks;
+        tasks.push_back(Value(0, 7));
+        tasks.push_back(waiter());
+        auto [index, value] = co_await WhenAny(std::move(tasks), cancel);
+        CHECK(index == 0 && value == 7);
+        CHECK(cancelled == 1);
+    }
+
+    //* 胜出任务的异常重新抛出给等待方
+    {
+        CancellationSource cancel;
+        std::vector<Task<int>> tasks;
+        tasks.push_back(Fail(5));
+        tasks.push_back(Sleep(5000, cancel.Token()));
+        bool thrown = false;
+        try {
+            co_await WhenAny(std::move(tasks), cancel);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+}
+
+Task<void> Run(EventLoop& loop, bool& passed) {
+    co_await TestWhenAll();
+    co_await TestWhenAny();
+    passed = true;
+    loop.Stop();
+}
+
+}  // namespace
+
+int main() {
+    EventLoop loop;
+    t_loop = &loop;
+    bool passed = false;
+    loop.RunInLoop([&]() { Run(loop, passed).Detach(); });
+    loop.Loop();
+    CHECK(passed);
+    std::printf("WhenAllTest passed\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+// WorkStealingDeque 多线程压力测试: 所属线程 Push/Pop, 多个窃取者 Steal,
+// 检查每个元素恰好被取走一次 (不丢失、不重复), 覆盖扩容和最后一个元素的竞争
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "WorkStealingDeque.h"
+
+namespace {
+
+// 运行一轮: 所属线程压入 total 个元素, 每压入 popEvery 个弹出一个, 最后弹空
+void Run(int64_t total, int popEvery, int thieves) {
+    WorkStealingDeque<int64_t> deque(2);  // 从最小容量开始, 迫使多次扩容
+    std::vector<std::atomic<int>> seen(total);
+    std::atomic<bool> done{false};
+    std::atomic<int64_t> stolen{0};
+
+    auto take = [&](int64_t item) {
+        CHECK(item >= 0 && item < total);
+        CHECK(seen[item].fetch_add(1, std::memory_order_relaxed) == 0);  // 不重复
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thieves; ++i) {
+        threads.emplace_back([&]() {
+            int64_t item = 0;
+            while (true) {
+                // 先读 done 再窃取: done 之后所属线程不再压入, 窃取失败即为空
+                bool finished = done.load(std::memory_order_acquire);
+                if (deque.Steal(item)) {
+                    take(item);
+                    stolen.fetch_add(1, std::memory_order_relaxed);
+                } else if (finished && deque.Empty()) {
+                    break;
+                }
+            }
+        });
+    }
+
+    int64_t item = 0;
+    for (int64_t i = 0; i < total; ++i) {
+        deque.Push(i);
+        if (popEvery > 0 && i % popEvery == 0 && deque.Pop(item)) {
+            take(item);
+        }
+    }
+    while (deque.Pop(item)) {
+        take(item);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+
+    for (int64_t i = 0; i < total; ++i) {
+        CHECK(seen[i].load() == 1);  // 不丢失
+    }
+    std::printf("total=%lld popEvery=%d thieves=%d stolen=%lld\n", static_cast<long long>(total),
+                popEvery, thieves, static_cast<long long>(stolen.load()));
+}
+
+// 最后一个元素的竞争: 每轮只放一个元素, 所属线程 Pop 与窃取者 Steal 同时抢
+void RunLastElementRace(int64_t rounds, int thieves) {
+    WorkStealingDeque<int64_t> deque(2);
+    std::vector<std::atomic<int>> seen(rounds);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thieves; ++i) {
+        threads.emplace_back([&]() {
+            int64_t item = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                if (deque.Steal(item)) seen[item].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    int64_t item = 0;
+    for (int64_t i = 0; i < rounds; ++i) {
+        deque.Push(i);
+        if (deque.Pop(item)) seen[item].fetch_add(1, std::memory_order_relaxed);
+        // 等这个元素被取走再开始下一轮, 保证每轮都只有最后一个元素
+        while (!deque.Empty()) {
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    for (int64_t i = 0; i < rounds; ++i) {
+        CHECK(seen[i].load() == 1);
+    }
+    std::printf("last-element race: rounds=%lld thieves=%d\n", static_cast<long long>(rounds),
+                thieves);
+}
+
+}  // namespace
+
+int main() {
+    Run(200000, 0, 3);  // 只有窃取者消费
+    Run(200000, 2, 3);  // Pop 与 Steal 交错
+    Run(200000, 1, 1);
+    RunLastElementRace(50000, 2);
+    std::printf("WorkStealingDequeTest passed\n");
+    return 0;
+}